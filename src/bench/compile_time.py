@@ -0,0 +1,176 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+"""
+Compile-time cost of each O-MVLL pass.
+
+Each pass runs alone over generated corpora (large switch-heavy functions,
+string-literal-heavy modules, deep loops and many small functions). For each
+of them, the benchmark reports the compile time, the peak RSS of the compiler
+and the number of IR instructions, against a build without the plugin.
+
+With --baseline, the results are compared against a previous --json output,
+and the script fails when a pass got slower or bigger than --threshold.
+"""
+
+import argparse
+import platform
+import re
+import sys
+from pathlib import Path
+
+import harness
+
+# Corpora, generated for a given scale factor.
+
+def gen_switches(scale: int) -> str:
+    out = []
+    for f in range(20 * scale):
+        out.append(f"int switch_{f}(int x, int y) {{")
+        out.append("  switch (x) {")
+        for c in range(256):
+            out.append(f"  case {c}: y = y * {c + 3} + (x ^ {c * 7 + 1}); break;")
+        out.append("  default: y -= x;")
+        out.append("  }")
+        out.append("  return y;")
+        out.append("}")
+    return "\n".join(out) + "\n"
+
+def gen_strings(scale: int) -> str:
+    out = ["void sink(const char *);"]
+    for f in range(100 * scale):
+        out.append(f"void strings_{f}(void) {{")
+        for s in range(20):
+            out.append(f'  sink("literal {f}.{s}: the quick brown fox jumps over the lazy dog");')
+        out.append("}")
+    return "\n".join(out) + "\n"
+
+def gen_loops(scale: int) -> str:
+    depth = 6
+    out = []
+    for f in range(20 * scale):
+        out.append(f"unsigned loops_{f}(const unsigned *a, unsigned n) {{")
+        out.append(f"  unsigned acc = {f + 1};")
+        for d in range(depth):
+            out.append("  " * (d + 1) + f"for (unsigned i{d} = 0; i{d} < n; ++i{d})")
+        index = " ^ ".join(f"i{d}" for d in range(depth))
+        out.append("  " * (depth + 1) + f"acc += a[({index}) & 63] * {f + 3} + (acc >> 1);")
+        out.append("  return acc;")
+        out.append("}")
+    return "\n".join(out) + "\n"
+
+def gen_small_functions(scale: int) -> str:
+    out = []
+    for f in range(3000 * scale):
+        call = f" + small_{f - 1}(x >> 1)" if f > 0 else ""
+        out.append(f"int small_{f}(int x) {{ return (x ^ {f}) * {f % 13 + 3}{call}; }}")
+    return "\n".join(out) + "\n"
+
+CORPORA = {
+    "switches": gen_switches,
+    "strings": gen_strings,
+    "loops": gen_loops,
+    "small-functions": gen_small_functions,
+}
+
+NO_PLUGIN = "(no plugin)"
+
+# Instructions are the non-label lines within function bodies.
+LABEL_RE = re.compile(r"^[\w.$-]+:")
+
+def count_instructions(ll: Path) -> int:
+    count = 0
+    in_body = False
+    for line in ll.read_text().splitlines():
+        if line.startswith("define "):
+            in_body = True
+        elif line.startswith("}"):
+            in_body = False
+        elif in_body and line.strip() and not LABEL_RE.match(line) \
+                and not line.lstrip().startswith(";"):
+            count += 1
+    return count
+
+def run_pass(args, name: str, source: Path, work_dir: Path) -> dict:
+    base = [args.clang, "-target", args.target, "-O1", source]
+    env = None
+    if name != NO_PLUGIN:
+        config = harness.write_config(work_dir / f"config_{name}.py", [name])
+        env = harness.plugin_env(config)
+        base[1:1] = [f"-fpass-plugin={args.plugin}"]
+
+    tag = "baseline" if name == NO_PLUGIN else name
+    obj = work_dir / f"{source.stem}.{tag}.o"
+    ll = work_dir / f"{source.stem}.{tag}.ll"
+    cost = harness.best_of(args.repeat, base + ["-c", "-o", obj], env)
+    harness.measure(base + ["-S", "-emit-llvm", "-o", ll], env)
+    return {
+        "seconds": cost.seconds,
+        "max_rss": cost.max_rss,
+        "instructions": count_instructions(ll),
+    }
+
+def print_table(corpus: str, entries: dict):
+    ref = entries[NO_PLUGIN]
+    print(f"\n== {corpus}")
+    print(f"{'pass':<24}{'time (s)':>10}{'slowdown':>10}{'peak RSS (MB)':>15}"
+          f"{'IR insts':>10}{'growth':>8}")
+    for name, values in entries.items():
+        print(f"{name:<24}{values['seconds']:>10.3f}"
+              f"{values['seconds'] / ref['seconds']:>9.2f}x"
+              f"{values['max_rss'] / (1 << 20):>15.1f}"
+              f"{values['instructions']:>10}"
+              f"{values['instructions'] / max(ref['instructions'], 1):>7.2f}x")
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clang", required=True, help="Clang driver loading the plugin")
+    parser.add_argument("--plugin", required=True, help="Path to the O-MVLL plugin")
+    parser.add_argument("--abi", default="Android", help="ABI the plugin was built for")
+    parser.add_argument("--target", help="Target triple (default: derived from --abi)")
+    parser.add_argument("--work-dir", type=Path, default=Path("omvll-bench"))
+    parser.add_argument("--scale", type=int, default=1, help="Size factor of the corpora")
+    parser.add_argument("--repeat", type=int, default=3, help="Runs per measure (best time)")
+    parser.add_argument("--passes", nargs="+", choices=list(harness.PASS_CALLBACKS),
+                        default=list(harness.PASS_CALLBACKS))
+    parser.add_argument("--corpora", nargs="+", choices=list(CORPORA), default=list(CORPORA))
+    parser.add_argument("--json", type=Path, help="Write the results to this file")
+    parser.add_argument("--baseline", type=Path, help="Results to compare against")
+    parser.add_argument("--threshold", type=float, default=1.10,
+                        help="Tolerated ratio over the baseline (default: 1.10)")
+
+    args = parser.parse_args()
+    args.target = args.target or harness.default_target(args.abi)
+    args.work_dir.mkdir(parents=True, exist_ok=True)
+
+    results = {}
+    for corpus in args.corpora:
+        source = args.work_dir / f"{corpus}.c"
+        source.write_text(CORPORA[corpus](args.scale))
+
+        entries = {}
+        for name in [NO_PLUGIN] + args.passes:
+            entries[name] = run_pass(args, name, source, args.work_dir)
+        results[corpus] = entries
+        print_table(corpus, entries)
+
+    if args.json:
+        meta = {
+            "benchmark": "compile-time",
+            "host": platform.node(),
+            "target": args.target,
+            "scale": args.scale,
+        }
+        harness.save_results(args.json, meta, results)
+
+    if args.baseline:
+        regressions = harness.compare_results(results, args.baseline,
+                                              ["seconds", "max_rss", "instructions"],
+                                              args.threshold)
+        return harness.report_regressions(regressions)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main())
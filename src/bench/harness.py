@@ -0,0 +1,147 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+"""Helpers shared by the O-MVLL benchmarks."""
+
+import json
+import os
+import subprocess
+import sys
+import time
+from dataclasses import dataclass
+from pathlib import Path
+
+# Callbacks enabling each pass, in the order of the pass registry of the plugin.
+# Cleaning runs whenever the plugin is loaded: it gets no callback.
+PASS_CALLBACKS = {
+    "AntiHook": """
+    def anti_hooking(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "FunctionOutline": """
+    def function_outline(self, mod: omvll.Module, func: omvll.Function):
+        return omvll.FunctionOutlineWithProbability(50)
+""",
+    "StringEncoding": """
+    def obfuscate_string(self, _, __, string: bytes):
+        return True
+""",
+    "OpaqueFieldAccess": """
+    def obfuscate_struct_access(self, _, __, struct):
+        return True
+""",
+    "BasicBlockDuplicate": """
+    def basic_block_duplicate(self, mod: omvll.Module, func: omvll.Function):
+        return omvll.BasicBlockDuplicateWithProbability(50)
+""",
+    "ControlFlowFlattening": """
+    def flatten_cfg(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "BreakControlFlow": """
+    def break_control_flow(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "OpaqueConstants": """
+    def obfuscate_constants(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "Arithmetic": """
+    def obfuscate_arithmetic(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "IndirectCall": """
+    def indirect_call(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "IndirectBranch": """
+    def indirect_branch(self, mod: omvll.Module, func: omvll.Function):
+        return True
+""",
+    "Cleaning": "",
+}
+
+CONFIG_TEMPLATE = """#
+# Generated by the O-MVLL benchmarks.
+#
+
+import omvll
+from functools import lru_cache
+
+class BenchConfig(omvll.ObfuscationConfig):
+    omvll.config.shuffle_functions = False
+{settings}
+    def __init__(self):
+        super().__init__()
+{callbacks}
+@lru_cache(maxsize=1)
+def omvll_get_config() -> omvll.ObfuscationConfig:
+    return BenchConfig()
+"""
+
+def default_target(abi: str) -> str:
+    return "arm64-apple-ios" if abi == "Apple" else "aarch64-linux-android"
+
+def write_config(path: Path, passes=(), settings=(), extra_callbacks="") -> Path:
+    """Write an O-MVLL configuration enabling the given passes."""
+    callbacks = "".join(PASS_CALLBACKS[name] for name in passes) + extra_callbacks
+    lines = "".join(f"    {setting}\n" for setting in settings)
+    path.write_text(CONFIG_TEMPLATE.format(settings=lines, callbacks=callbacks))
+    return path
+
+def plugin_env(config: Path) -> dict:
+    return dict(os.environ, OMVLL_CONFIG=str(config))
+
+@dataclass
+class Measure:
+    seconds: float
+    max_rss: int  # In bytes.
+
+def measure(cmd, env=None, cwd=None) -> Measure:
+    """Run cmd, and return its wall time and peak RSS."""
+    start = time.perf_counter()
+    proc = subprocess.Popen([str(arg) for arg in cmd], env=env, cwd=cwd,
+                            stdout=subprocess.DEVNULL)
+    _, status, usage = os.wait4(proc.pid, 0)
+    seconds = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        raise RuntimeError(f"{' '.join(map(str, cmd))} failed ({proc.returncode})")
+
+    # ru_maxrss is in kilobytes on Linux, but in bytes on macOS.
+    scale = 1 if sys.platform == "darwin" else 1024
+    return Measure(seconds, usage.ru_maxrss * scale)
+
+def best_of(repeat: int, cmd, env=None, cwd=None) -> Measure:
+    runs = [measure(cmd, env, cwd) for _ in range(max(repeat, 1))]
+    return Measure(min(run.seconds for run in runs),
+                   max(run.max_rss for run in runs))
+
+def save_results(path: Path, meta: dict, results: dict):
+    path.write_text(json.dumps({"meta": meta, "results": results}, indent=2))
+
+def compare_results(results: dict, baseline: Path, metrics, threshold: float):
+    """
+    Return the (group, name, metric, baseline, value) entries of results that
+    exceed their baseline by more than threshold (e.g. 1.10 for 10%).
+    """
+    reference = json.loads(baseline.read_text())["results"]
+    regressions = []
+    for group, entries in results.items():
+        for name, values in entries.items():
+            ref = reference.get(group, {}).get(name)
+            if ref is None:
+                continue
+            for metric in metrics:
+                if ref.get(metric) is None or values.get(metric) is None:
+                    continue
+                if values[metric] > ref[metric] * threshold:
+                    regressions.append((group, name, metric, ref[metric], values[metric]))
+    return regressions
+
+def report_regressions(regressions) -> int:
+    for group, name, metric, ref, value in regressions:
+        ratio = f"{value / ref:.2f}x" if ref else "new"
+        print(f"REGRESSION {group}/{name}: {metric} {ref:.4g} -> {value:.4g} ({ratio})")
+    return 1 if regressions else 0
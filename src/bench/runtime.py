@@ -0,0 +1,151 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+"""
+Runtime overhead of each O-MVLL pass.
+
+Each kernel of runtime/kernels (hashing, parsing, sorting, JNI-style glue and
+string-heavy startup) is built without the plugin, then with each pass alone,
+and linked against runtime/driver.c, which is never obfuscated. The driver
+reports the wall time and, through perf_event_open when available, the
+cycles, instructions and L1 instruction cache misses of the kernel.
+
+The kernels return a checksum of their work: a pass that changes it is
+reported as a miscompilation. With --baseline, the results are compared
+against a previous --json output, and the script fails when a pass got more
+expensive than --threshold.
+"""
+
+import argparse
+import json
+import platform
+import subprocess
+import sys
+from pathlib import Path
+
+import harness
+
+RUNTIME_DIR = Path(__file__).resolve().parent / "runtime"
+DRIVER = RUNTIME_DIR / "driver.c"
+KERNELS = sorted(p for p in (RUNTIME_DIR / "kernels").iterdir()
+                 if p.suffix in (".c", ".cpp"))
+
+NO_PLUGIN = "(no plugin)"
+COUNTERS = ["cycles", "instructions", "icache_misses"]
+
+def build(args, name: str, kernel: Path, driver_obj: Path) -> Path:
+    tag = "baseline" if name == NO_PLUGIN else name
+    obj = args.work_dir / f"{kernel.stem}.{tag}.o"
+    exe = args.work_dir / f"{kernel.stem}.{tag}"
+
+    cmd = [args.clang, "-target", args.target, "-O2", *args.cflags]
+    if kernel.suffix == ".cpp":
+        cmd += ["-fno-exceptions", "-fno-rtti"]
+    env = None
+    if name != NO_PLUGIN:
+        config = harness.write_config(args.work_dir / f"config_{name}.py", [name])
+        env = harness.plugin_env(config)
+        cmd += [f"-fpass-plugin={args.plugin}"]
+
+    harness.measure(cmd + ["-c", kernel, "-o", obj], env)
+    harness.measure([args.host_cc, driver_obj, obj, "-o", exe])
+    return exe
+
+def run(args, exe: Path) -> dict:
+    runs = []
+    for _ in range(max(args.repeat, 1)):
+        out = subprocess.run([str(exe), str(args.iterations)], check=True,
+                             capture_output=True, text=True).stdout
+        runs.append(json.loads(out))
+
+    # Noise only adds up: keep the best value of each metric.
+    result = {"checksum": runs[0]["checksum"]}
+    for metric in ["ns"] + COUNTERS:
+        values = [r[metric] for r in runs if r[metric] is not None]
+        result[metric] = min(values) if values else None
+    return result
+
+def print_table(kernel: str, entries: dict):
+    ref = entries[NO_PLUGIN]
+    # Cycles are steadier than the wall time, when available.
+    key = "cycles" if ref["cycles"] else "ns"
+    print(f"\n== {kernel}")
+    print(f"{'pass':<24}{'time (us)':>12}{'cycles':>14}{'instructions':>14}"
+          f"{'icache misses':>15}{'overhead':>10}")
+    def fmt(value):
+        return "n/a" if value is None else str(value)
+
+    for name, values in entries.items():
+        status = ""
+        if values["checksum"] != ref["checksum"]:
+            status = "  MISCOMPILED"
+        print(f"{name:<24}{values['ns'] / 1000:>12.1f}{fmt(values['cycles']):>14}"
+              f"{fmt(values['instructions']):>14}{fmt(values['icache_misses']):>15}"
+              f"{values[key] / ref[key]:>9.2f}x{status}")
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clang", required=True, help="Clang driver loading the plugin")
+    parser.add_argument("--plugin", required=True, help="Path to the O-MVLL plugin")
+    parser.add_argument("--host-cc", default="cc", help="Compiler building and linking the driver")
+    parser.add_argument("--target", default="x86_64-pc-linux-gnu", help="Target triple of the kernels")
+    parser.add_argument("--cflags", nargs="*", default=[], help="Extra flags for the kernels")
+    parser.add_argument("--work-dir", type=Path, default=Path("omvll-bench-runtime"))
+    parser.add_argument("--iterations", type=int, default=100, help="Iterations of each kernel")
+    parser.add_argument("--repeat", type=int, default=5, help="Runs per measure (best values)")
+    parser.add_argument("--passes", nargs="+", choices=list(harness.PASS_CALLBACKS),
+                        default=list(harness.PASS_CALLBACKS))
+    parser.add_argument("--kernels", nargs="+", choices=[k.stem for k in KERNELS],
+                        default=[k.stem for k in KERNELS])
+    parser.add_argument("--json", type=Path, help="Write the results to this file")
+    parser.add_argument("--baseline", type=Path, help="Results to compare against")
+    parser.add_argument("--threshold", type=float, default=1.10,
+                        help="Tolerated ratio over the baseline (default: 1.10)")
+
+    args = parser.parse_args()
+    args.work_dir.mkdir(parents=True, exist_ok=True)
+
+    if sys.platform != "linux" or platform.machine() != "x86_64":
+        print("warning: the hardware counters are only collected on x86-64 Linux")
+
+    driver_obj = args.work_dir / "driver.o"
+    harness.measure([args.host_cc, "-O2", "-c", DRIVER, "-o", driver_obj])
+
+    results = {}
+    miscompiled = False
+    for kernel in KERNELS:
+        if kernel.stem not in args.kernels:
+            continue
+
+        entries = {}
+        for name in [NO_PLUGIN] + args.passes:
+            entries[name] = run(args, build(args, name, kernel, driver_obj))
+            miscompiled |= entries[name]["checksum"] != entries[NO_PLUGIN]["checksum"]
+        results[kernel.stem] = entries
+        print_table(kernel.stem, entries)
+
+    if args.json:
+        meta = {
+            "benchmark": "runtime",
+            "host": platform.node(),
+            "target": args.target,
+            "iterations": args.iterations,
+        }
+        harness.save_results(args.json, meta, results)
+
+    status = 1 if miscompiled else 0
+    if args.baseline:
+        # The wall time is too noisy to fail on, unless it is all there is.
+        has_counters = any(values["cycles"] is not None
+                           for entries in results.values()
+                           for values in entries.values())
+        metrics = COUNTERS if has_counters else ["ns"]
+        regressions = harness.compare_results(results, args.baseline,
+                                              metrics, args.threshold)
+        status |= harness.report_regressions(regressions)
+    return status
+
+if __name__ == "__main__":
+    sys.exit(main())
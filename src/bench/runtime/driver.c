@@ -0,0 +1,112 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Runs the kernel under test and prints its cost as a JSON object. The driver
+// itself is never obfuscated. Hardware counters come from perf_event_open when
+// available (Linux, with a permissive perf_event_paranoid), they are null
+// otherwise.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+// Provided by the kernel. The checksum depends on all the work done, so that
+// it cannot be optimized away, and must not depend on the obfuscation.
+uint64_t bench_kernel(uint32_t iterations);
+
+enum { Cycles, Instructions, ICacheMisses, NumCounters };
+
+static const char *const CounterNames[NumCounters] = {
+    "cycles", "instructions", "icache_misses"};
+
+static int openCounter(int Counter) {
+#ifdef __linux__
+  struct perf_event_attr Attr;
+  memset(&Attr, 0, sizeof(Attr));
+  Attr.size = sizeof(Attr);
+  Attr.disabled = 1;
+  Attr.exclude_kernel = 1;
+  Attr.exclude_hv = 1;
+
+  switch (Counter) {
+  case Cycles:
+    Attr.type = PERF_TYPE_HARDWARE;
+    Attr.config = PERF_COUNT_HW_CPU_CYCLES;
+    break;
+  case Instructions:
+    Attr.type = PERF_TYPE_HARDWARE;
+    Attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+    break;
+  case ICacheMisses:
+    Attr.type = PERF_TYPE_HW_CACHE;
+    Attr.config = PERF_COUNT_HW_CACHE_L1I |
+                  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    break;
+  }
+  return (int)syscall(SYS_perf_event_open, &Attr, 0, -1, -1, 0);
+#else
+  (void)Counter;
+  return -1;
+#endif
+}
+
+static void setCounters(const int *FDs, int Enable) {
+#ifdef __linux__
+  for (int I = 0; I < NumCounters; ++I)
+    if (FDs[I] >= 0)
+      ioctl(FDs[I], Enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+#else
+  (void)FDs;
+  (void)Enable;
+#endif
+}
+
+static uint64_t nowNs(void) {
+  struct timespec TS;
+  clock_gettime(CLOCK_MONOTONIC, &TS);
+  return (uint64_t)TS.tv_sec * 1000000000u + (uint64_t)TS.tv_nsec;
+}
+
+int main(int argc, char **argv) {
+  uint32_t Iterations = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1;
+
+  // Warm up the caches and the branch predictors.
+  uint64_t Checksum = bench_kernel(1);
+
+  int FDs[NumCounters];
+  for (int I = 0; I < NumCounters; ++I)
+    FDs[I] = openCounter(I);
+
+  setCounters(FDs, 1);
+  uint64_t Start = nowNs();
+  Checksum ^= bench_kernel(Iterations);
+  uint64_t Elapsed = nowNs() - Start;
+  setCounters(FDs, 0);
+
+  printf("{\"checksum\": \"%016" PRIx64 "\", \"ns\": %" PRIu64, Checksum,
+         Elapsed);
+  for (int I = 0; I < NumCounters; ++I) {
+    uint64_t Value = 0;
+    if (FDs[I] >= 0 && read(FDs[I], &Value, sizeof(Value)) == sizeof(Value))
+      printf(", \"%s\": %" PRIu64, CounterNames[I], Value);
+    else
+      printf(", \"%s\": null", CounterNames[I]);
+    if (FDs[I] >= 0)
+      close(FDs[I]);
+  }
+  printf("}\n");
+  return 0;
+}
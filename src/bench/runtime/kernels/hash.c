@@ -0,0 +1,55 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Hashing: FNV-1a and a table-driven CRC-32 over a pseudo-random buffer.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BUFFER_SIZE 16384
+
+static uint8_t Buffer[BUFFER_SIZE];
+static uint32_t CrcTable[256];
+
+static void init(void) {
+  uint32_t State = 0x12345678;
+  for (size_t I = 0; I < BUFFER_SIZE; ++I) {
+    State = State * 1664525u + 1013904223u;
+    Buffer[I] = (uint8_t)(State >> 24);
+  }
+
+  for (uint32_t I = 0; I < 256; ++I) {
+    uint32_t C = I;
+    for (int K = 0; K < 8; ++K)
+      C = (C & 1) ? 0xEDB88320u ^ (C >> 1) : C >> 1;
+    CrcTable[I] = C;
+  }
+}
+
+static uint64_t fnv1a(const uint8_t *Data, size_t Size) {
+  uint64_t Hash = 0xcbf29ce484222325ull;
+  for (size_t I = 0; I < Size; ++I) {
+    Hash ^= Data[I];
+    Hash *= 0x100000001b3ull;
+  }
+  return Hash;
+}
+
+static uint32_t crc32(const uint8_t *Data, size_t Size) {
+  uint32_t Crc = 0xFFFFFFFFu;
+  for (size_t I = 0; I < Size; ++I)
+    Crc = CrcTable[(Crc ^ Data[I]) & 0xFF] ^ (Crc >> 8);
+  return Crc ^ 0xFFFFFFFFu;
+}
+
+uint64_t bench_kernel(uint32_t Iterations) {
+  init();
+  uint64_t Checksum = 0;
+  for (uint32_t I = 0; I < Iterations; ++I) {
+    Buffer[I % BUFFER_SIZE] ^= (uint8_t)I;
+    Checksum += fnv1a(Buffer, BUFFER_SIZE) ^ crc32(Buffer, BUFFER_SIZE);
+  }
+  return Checksum;
+}
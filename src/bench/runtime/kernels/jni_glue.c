@@ -0,0 +1,92 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// JNI-style glue: native methods that go through a table of environment
+// functions to access their arguments, as JNI code does with JNIEnv.
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct Array {
+  int32_t Length;
+  int32_t *Elements;
+} Array;
+
+typedef const struct NativeInterface *Env;
+
+struct NativeInterface {
+  int32_t (*GetArrayLength)(Env *, const Array *);
+  int32_t *(*GetIntArrayElements)(Env *, Array *, uint8_t *);
+  void (*ReleaseIntArrayElements)(Env *, Array *, int32_t *, int32_t);
+  int32_t (*CallIntMethod)(Env *, int32_t, int32_t);
+};
+
+static int32_t getArrayLength(Env *E, const Array *A) {
+  (void)E;
+  return A->Length;
+}
+
+static int32_t *getIntArrayElements(Env *E, Array *A, uint8_t *IsCopy) {
+  (void)E;
+  if (IsCopy)
+    *IsCopy = 0;
+  return A->Elements;
+}
+
+static void releaseIntArrayElements(Env *E, Array *A, int32_t *Elements,
+                                    int32_t Mode) {
+  (void)E;
+  (void)A;
+  (void)Elements;
+  (void)Mode;
+}
+
+static int32_t callIntMethod(Env *E, int32_t Receiver, int32_t Arg) {
+  (void)E;
+  return Receiver * 33 + Arg;
+}
+
+static const struct NativeInterface Interface = {
+    getArrayLength, getIntArrayElements, releaseIntArrayElements,
+    callIntMethod};
+
+#define ARRAY_SIZE 64
+
+static int32_t Storage[ARRAY_SIZE];
+
+int32_t Java_re_obfuscator_bench_Native_sum(Env *E, int32_t Receiver,
+                                            Array *A) {
+  int32_t Length = (*E)->GetArrayLength(E, A);
+  int32_t *Elements = (*E)->GetIntArrayElements(E, A, NULL);
+  int32_t Sum = 0;
+  for (int32_t I = 0; I < Length; ++I)
+    Sum += Elements[I];
+  (*E)->ReleaseIntArrayElements(E, A, Elements, 0);
+  return (*E)->CallIntMethod(E, Receiver, Sum);
+}
+
+int32_t Java_re_obfuscator_bench_Native_scale(Env *E, int32_t Receiver,
+                                              Array *A, int32_t Factor) {
+  int32_t *Elements = (*E)->GetIntArrayElements(E, A, NULL);
+  Elements[Receiver % ARRAY_SIZE] *= Factor;
+  (*E)->ReleaseIntArrayElements(E, A, Elements, 0);
+  return (*E)->CallIntMethod(E, Receiver, Factor);
+}
+
+uint64_t bench_kernel(uint32_t Iterations) {
+  Env E = &Interface;
+  Array A = {ARRAY_SIZE, Storage};
+  for (int32_t I = 0; I < ARRAY_SIZE; ++I)
+    Storage[I] = I;
+
+  uint64_t Checksum = 0;
+  for (uint32_t I = 0; I < Iterations * 1024; ++I) {
+    Checksum += (uint32_t)Java_re_obfuscator_bench_Native_sum(&E, (int32_t)I, &A);
+    Checksum += (uint32_t)Java_re_obfuscator_bench_Native_scale(&E, (int32_t)I,
+                                                               &A, 3);
+    Storage[I % ARRAY_SIZE] &= 0xFFFF;
+  }
+  return Checksum;
+}
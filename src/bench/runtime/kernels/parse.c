@@ -0,0 +1,87 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Parsing: a switch-based tokenizer over a generated key=value document.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DOCUMENT_SIZE 16384
+
+enum State { Start, Key, Equal, Number, Identifier, Comment };
+
+static char Document[DOCUMENT_SIZE];
+
+static void init(void) {
+  static const char *const Lines[] = {
+      "width = 1280\n", "height=720\n",  "# comment line\n",
+      "mode = fast\n",  "depth = 32\n",  "name = o_mvll\n",
+  };
+
+  size_t Pos = 0;
+  for (size_t L = 0; Pos + 32 < DOCUMENT_SIZE; ++L)
+    for (const char *C = Lines[L % 6]; *C; ++C)
+      Document[Pos++] = *C;
+  Document[Pos] = '\0';
+}
+
+static uint64_t parse(const char *Text) {
+  enum State S = Start;
+  uint64_t Hash = 0;
+  uint64_t Value = 0;
+
+  for (const char *C = Text; *C; ++C) {
+    char Ch = *C;
+    switch (S) {
+    case Start:
+      if (Ch == '#')
+        S = Comment;
+      else if ((Ch >= 'a' && Ch <= 'z') || Ch == '_')
+        S = Key, Hash = Hash * 31 + (uint64_t)Ch;
+      break;
+    case Key:
+      if (Ch == '=')
+        S = Equal;
+      else if (Ch != ' ')
+        Hash = Hash * 31 + (uint64_t)Ch;
+      break;
+    case Equal:
+      if (Ch >= '0' && Ch <= '9')
+        S = Number, Value = (uint64_t)(Ch - '0');
+      else if (Ch != ' ')
+        S = Identifier, Value = (uint64_t)Ch;
+      break;
+    case Number:
+      if (Ch >= '0' && Ch <= '9') {
+        Value = Value * 10 + (uint64_t)(Ch - '0');
+      } else {
+        Hash ^= Value;
+        S = Start;
+      }
+      break;
+    case Identifier:
+      if (Ch == '\n') {
+        Hash += Value;
+        S = Start;
+      } else {
+        Value = Value * 131 + (uint64_t)Ch;
+      }
+      break;
+    case Comment:
+      if (Ch == '\n')
+        S = Start;
+      break;
+    }
+  }
+  return Hash;
+}
+
+uint64_t bench_kernel(uint32_t Iterations) {
+  init();
+  uint64_t Checksum = 0;
+  for (uint32_t I = 0; I < Iterations; ++I)
+    Checksum += parse(Document) + I;
+  return Checksum;
+}
@@ -0,0 +1,62 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Sorting: a templated quicksort, with an insertion sort for small ranges.
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace {
+
+constexpr size_t ArraySize = 8192;
+uint32_t Values[ArraySize];
+
+template <typename T> void insertionSort(T *First, T *Last) {
+  for (T *I = First + 1; I < Last; ++I) {
+    T Value = *I;
+    T *J = I;
+    for (; J > First && Value < J[-1]; --J)
+      *J = J[-1];
+    *J = Value;
+  }
+}
+
+template <typename T> void quickSort(T *First, T *Last) {
+  while (Last - First > 16) {
+    T Pivot = First[(Last - First) / 2];
+    T *I = First;
+    T *J = Last - 1;
+    while (I <= J) {
+      while (*I < Pivot)
+        ++I;
+      while (Pivot < *J)
+        --J;
+      if (I <= J) {
+        T Tmp = *I;
+        *I++ = *J;
+        *J-- = Tmp;
+      }
+    }
+    quickSort(First, J + 1);
+    First = I;
+  }
+  insertionSort(First, Last);
+}
+
+} // end anonymous namespace
+
+extern "C" uint64_t bench_kernel(uint32_t Iterations) {
+  uint64_t Checksum = 0;
+  uint32_t State = 0xC0FFEE;
+  for (uint32_t I = 0; I < Iterations; ++I) {
+    for (size_t K = 0; K < ArraySize; ++K) {
+      State = State * 1664525u + 1013904223u;
+      Values[K] = State >> 8;
+    }
+    quickSort(Values, Values + ArraySize);
+    Checksum += Values[I % ArraySize] ^ Values[ArraySize / 2];
+  }
+  return Checksum;
+}
@@ -0,0 +1,82 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// String-heavy startup: an application registers its settings by name, then
+// looks them up, as done when parsing a configuration at startup.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MAX_SETTINGS 64
+
+typedef struct Setting {
+  const char *Name;
+  const char *Value;
+} Setting;
+
+static Setting Settings[MAX_SETTINGS];
+static size_t NumSettings;
+
+static int compare(const char *A, const char *B) {
+  while (*A && *A == *B)
+    ++A, ++B;
+  return (unsigned char)*A - (unsigned char)*B;
+}
+
+static void set(const char *Name, const char *Value) {
+  for (size_t I = 0; I < NumSettings; ++I) {
+    if (compare(Settings[I].Name, Name) == 0) {
+      Settings[I].Value = Value;
+      return;
+    }
+  }
+  if (NumSettings < MAX_SETTINGS)
+    Settings[NumSettings++] = (Setting){Name, Value};
+}
+
+static const char *get(const char *Name) {
+  for (size_t I = 0; I < NumSettings; ++I)
+    if (compare(Settings[I].Name, Name) == 0)
+      return Settings[I].Value;
+  return "";
+}
+
+static void registerSettings(void) {
+  set("app.name", "O-MVLL benchmark");
+  set("app.version", "1.4.1");
+  set("network.endpoint", "https://api.example.com/v1/");
+  set("network.timeout", "30");
+  set("network.retries", "5");
+  set("storage.path", "/data/data/re.obfuscator.bench/files");
+  set("storage.quota", "104857600");
+  set("crypto.cipher", "AES-256-GCM");
+  set("crypto.kdf", "PBKDF2-HMAC-SHA256");
+  set("ui.theme", "dark");
+  set("ui.locale", "en_US");
+  set("log.level", "info");
+  set("log.path", "/data/data/re.obfuscator.bench/logs");
+  set("feature.sync", "enabled");
+  set("feature.analytics", "disabled");
+  set("feature.experiments", "control");
+}
+
+static uint64_t hashString(const char *S) {
+  uint64_t Hash = 5381;
+  while (*S)
+    Hash = Hash * 33 + (unsigned char)*S++;
+  return Hash;
+}
+
+uint64_t bench_kernel(uint32_t Iterations) {
+  uint64_t Checksum = 0;
+  for (uint32_t I = 0; I < Iterations * 256; ++I) {
+    NumSettings = 0;
+    registerSettings();
+    Checksum += hashString(get("network.endpoint"));
+    Checksum += hashString(get("crypto.cipher"));
+    Checksum += hashString(get("feature.experiments"));
+  }
+  return Checksum;
+}
@@ -0,0 +1,201 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+"""
+Startup latency of the strings encoded with StringEncOptGlobal.
+
+StringEncOptGlobal decodes each string in a global constructor, which runs
+before main. For modules with an increasing number of literals, the benchmark
+builds a program without the plugin and one with all its strings encoded that
+way, then reports the time to reach main, along with the size and the number of
+entries of .init_array.
+
+The time is measured by startup/launcher.c, which spawns the program with the
+spawn time as argument, and startup/main.c, which subtracts it at the entry of
+main. Neither is obfuscated. The literals are checksummed to detect
+miscompilations. With --baseline, the results are compared against a previous
+--json output, and the script fails when the startup got slower than
+--threshold.
+"""
+
+import argparse
+import json
+import platform
+import statistics
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+import harness
+
+STARTUP_DIR = Path(__file__).resolve().parent / "startup"
+LAUNCHER = STARTUP_DIR / "launcher.c"
+MAIN = STARTUP_DIR / "main.c"
+
+NO_PLUGIN = "(no plugin)"
+ENCODED = "StringEncOptGlobal"
+
+GLOBAL_STRINGS = """
+    def obfuscate_string(self, _, __, string: bytes):
+        return omvll.StringEncOptGlobal()
+"""
+
+LITERALS_PER_FUNCTION = 100
+
+def gen_literals(count: int) -> str:
+    out = []
+    functions = (count + LITERALS_PER_FUNCTION - 1) // LITERALS_PER_FUNCTION
+    for f in range(functions):
+        out.append(f"static void touch_{f}(void (*sink)(const char *)) {{")
+        for s in range(f * LITERALS_PER_FUNCTION,
+                       min((f + 1) * LITERALS_PER_FUNCTION, count)):
+            out.append(f'  sink("setting.{s}: the quick brown fox jumps over the lazy dog");')
+        out.append("}")
+    out.append("void bench_touch_literals(void (*sink)(const char *)) {")
+    out += [f"  touch_{f}(sink);" for f in range(functions)]
+    out.append("}")
+    return "\n".join(out) + "\n"
+
+def elf_init_array(path: Path):
+    """Size and number of entries of .init_array, None if path is not ELF."""
+    data = path.read_bytes()
+    if data[:4] != b"\x7fELF":
+        return None, None
+    is64 = data[4] == 2
+    order = "<" if data[5] == 1 else ">"
+    if is64:
+        shoff, = struct.unpack_from(order + "Q", data, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(order + "HHH", data, 0x3A)
+    else:
+        shoff, = struct.unpack_from(order + "I", data, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(order + "HHH", data, 0x2E)
+
+    def header(index):
+        base = shoff + index * shentsize
+        if is64:
+            name, = struct.unpack_from(order + "I", data, base)
+            offset, size = struct.unpack_from(order + "QQ", data, base + 0x18)
+        else:
+            name, = struct.unpack_from(order + "I", data, base)
+            offset, size = struct.unpack_from(order + "II", data, base + 0x10)
+        return name, offset, size
+
+    _, strtab, _ = header(shstrndx)
+    for index in range(shnum):
+        name, _, size = header(index)
+        end = data.index(b"\0", strtab + name)
+        if data[strtab + name:end] == b".init_array":
+            return size, size // (8 if is64 else 4)
+    return 0, 0
+
+def build(args, name: str, source: Path, main_obj: Path) -> Path:
+    tag = "baseline" if name == NO_PLUGIN else "global"
+    obj = args.work_dir / f"{source.stem}.{tag}.o"
+    exe = args.work_dir / f"{source.stem}.{tag}"
+
+    cmd = [args.clang, "-target", args.target, "-O2", *args.cflags]
+    env = None
+    if name != NO_PLUGIN:
+        config = harness.write_config(args.work_dir / "config_global_strings.py",
+                                      extra_callbacks=GLOBAL_STRINGS)
+        env = harness.plugin_env(config)
+        cmd += [f"-fpass-plugin={args.plugin}"]
+
+    harness.measure(cmd + ["-c", source, "-o", obj], env)
+    harness.measure([args.host_cc, main_obj, obj, "-o", exe])
+    return exe
+
+def run(args, launcher: Path, exe: Path) -> dict:
+    out = subprocess.run([str(launcher), str(args.runs), str(exe)], check=True,
+                         capture_output=True, text=True).stdout
+    latencies = [int(line) for line in out.split()]
+    check = subprocess.run([str(exe), "check"], check=True,
+                           capture_output=True, text=True).stdout
+
+    init_array, ctors = elf_init_array(exe)
+    return {
+        "checksum": json.loads(check)["checksum"],
+        "min_ns": min(latencies),
+        "median_ns": int(statistics.median(latencies)),
+        "init_array": init_array,
+        "ctors": ctors,
+        "size": exe.stat().st_size,
+    }
+
+def print_table(literals: int, entries: dict):
+    ref = entries[NO_PLUGIN]
+    print(f"\n== {literals} literals")
+    print(f"{'build':<24}{'min (us)':>12}{'median (us)':>14}{'slowdown':>10}"
+          f"{'.init_array':>13}{'ctors':>8}{'size (KB)':>11}")
+    def fmt(value):
+        return "n/a" if value is None else str(value)
+
+    for name, values in entries.items():
+        status = ""
+        if values["checksum"] != ref["checksum"]:
+            status = "  MISCOMPILED"
+        print(f"{name:<24}{values['min_ns'] / 1000:>12.1f}"
+              f"{values['median_ns'] / 1000:>14.1f}"
+              f"{values['median_ns'] / ref['median_ns']:>9.2f}x"
+              f"{fmt(values['init_array']):>13}{fmt(values['ctors']):>8}"
+              f"{values['size'] / 1024:>11.1f}{status}")
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--clang", required=True, help="Clang driver loading the plugin")
+    parser.add_argument("--plugin", required=True, help="Path to the O-MVLL plugin")
+    parser.add_argument("--host-cc", default="cc", help="Compiler building and linking the programs")
+    parser.add_argument("--target", default="x86_64-pc-linux-gnu", help="Target triple of the modules")
+    parser.add_argument("--cflags", nargs="*", default=[], help="Extra flags for the modules")
+    parser.add_argument("--work-dir", type=Path, default=Path("omvll-bench-startup"))
+    parser.add_argument("--literals", nargs="+", type=int, default=[1000, 10000, 100000],
+                        help="Number of literals of each module")
+    parser.add_argument("--runs", type=int, default=50, help="Launches per program")
+    parser.add_argument("--json", type=Path, help="Write the results to this file")
+    parser.add_argument("--baseline", type=Path, help="Results to compare against")
+    parser.add_argument("--threshold", type=float, default=1.10,
+                        help="Tolerated ratio over the baseline (default: 1.10)")
+
+    args = parser.parse_args()
+    args.work_dir.mkdir(parents=True, exist_ok=True)
+
+    launcher = args.work_dir / "launcher"
+    main_obj = args.work_dir / "main.o"
+    harness.measure([args.host_cc, "-O2", LAUNCHER, "-o", launcher])
+    harness.measure([args.host_cc, "-O2", "-c", MAIN, "-o", main_obj])
+
+    results = {}
+    miscompiled = False
+    for literals in args.literals:
+        source = args.work_dir / f"literals_{literals}.c"
+        source.write_text(gen_literals(literals))
+
+        entries = {}
+        for name in [NO_PLUGIN, ENCODED]:
+            entries[name] = run(args, launcher, build(args, name, source, main_obj))
+            miscompiled |= entries[name]["checksum"] != entries[NO_PLUGIN]["checksum"]
+        results[str(literals)] = entries
+        print_table(literals, entries)
+
+    if args.json:
+        meta = {
+            "benchmark": "startup",
+            "host": platform.node(),
+            "target": args.target,
+            "runs": args.runs,
+        }
+        harness.save_results(args.json, meta, results)
+
+    status = 1 if miscompiled else 0
+    if args.baseline:
+        regressions = harness.compare_results(results, args.baseline,
+                                              ["median_ns", "init_array"],
+                                              args.threshold)
+        status |= harness.report_regressions(regressions)
+    return status
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,59 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Spawns the program under test several times. Each child gets the time at
+// which it was spawned, and prints how long it took to reach main: loading,
+// relocations and the global constructors, e.g. the ones decoding the strings
+// protected with StringEncOptGlobal.
+//
+// usage: launcher <runs> <program>
+
+#include <inttypes.h>
+#include <spawn.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <time.h>
+
+extern char **environ;
+
+// Must match the clock of main.c.
+static uint64_t nowNs(void) {
+#ifdef __APPLE__
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+  struct timespec TS;
+  clock_gettime(CLOCK_MONOTONIC, &TS);
+  return (uint64_t)TS.tv_sec * 1000000000u + (uint64_t)TS.tv_nsec;
+#endif
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <runs> <program>\n", argv[0]);
+    return 1;
+  }
+
+  int Runs = atoi(argv[1]);
+  char Stamp[32];
+  char *Args[] = {argv[2], Stamp, NULL};
+
+  for (int I = 0; I < Runs; ++I) {
+    pid_t Pid;
+    int Status;
+    snprintf(Stamp, sizeof(Stamp), "%" PRIu64, nowNs());
+    if (posix_spawn(&Pid, Args[0], NULL, NULL, Args, environ) != 0) {
+      perror("posix_spawn");
+      return 1;
+    }
+    if (waitpid(Pid, &Status, 0) < 0 || !WIFEXITED(Status) ||
+        WEXITSTATUS(Status) != 0) {
+      fprintf(stderr, "%s failed\n", Args[0]);
+      return 1;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,52 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// Entry point of the programs spawned by launcher.c, never obfuscated. It
+// prints the time elapsed since the spawn as soon as main is reached. With
+// "check" instead of a spawn time, it prints a checksum of all the literals of
+// the generated module instead, which must not depend on the obfuscation.
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Provided by the generated module: calls Sink on each of its literals.
+void bench_touch_literals(void (*Sink)(const char *));
+
+static uint64_t Checksum = 0xcbf29ce484222325u;
+
+static void hashLiteral(const char *Str) {
+  for (; *Str; ++Str)
+    Checksum = (Checksum ^ (unsigned char)*Str) * 0x100000001b3u;
+}
+
+static uint64_t nowNs(void) {
+#ifdef __APPLE__
+  return clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+#else
+  struct timespec TS;
+  clock_gettime(CLOCK_MONOTONIC, &TS);
+  return (uint64_t)TS.tv_sec * 1000000000u + (uint64_t)TS.tv_nsec;
+#endif
+}
+
+int main(int argc, char **argv) {
+  uint64_t Entry = nowNs();
+  if (argc < 2)
+    return 1;
+
+  if (strcmp(argv[1], "check") == 0) {
+    bench_touch_literals(hashLiteral);
+    printf("{\"checksum\": %" PRIu64 "}\n", Checksum);
+    return 0;
+  }
+
+  uint64_t Spawn = strtoull(argv[1], NULL, 10);
+  printf("%" PRIu64 "\n", Entry - Spawn);
+  return 0;
+}
@@ -3,46 +3,58 @@
 // details.
 //
 
-#include "llvm/AsmParser/Parser.h"
-#include "llvm/ExecutionEngine/ExecutionEngine.h"
-#include "llvm/ExecutionEngine/Orc/LLJIT.h"
-#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
-#include "llvm/IR/DataLayout.h"
-#include "llvm/IR/IRBuilder.h"
-#include "llvm/IR/InlineAsm.h"
-#include "llvm/IR/LLVMContext.h"
-#include "llvm/IRReader/IRReader.h"
+#include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAsmInfo.h"
+#include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectFileInfo.h"
+#include "llvm/MC/MCObjectWriter.h"
+#include "llvm/MC/MCParser/MCAsmParser.h"
+#include "llvm/MC/MCParser/MCTargetAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCStreamer.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/MC/MCTargetOptions.h"
+#include "llvm/MC/TargetRegistry.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/ObjectFile.h"
-#include "llvm/Passes/PassBuilder.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
 #include "llvm/TargetParser/Host.h"
 #include "llvm/TargetParser/Triple.h"
-#include "llvm/Transforms/Utils/Cloning.h"
 
 #include "omvll/jitter.hpp"
 #include "omvll/utils.hpp"
 
+#include <map>
+#include <mutex>
+
 #include <spdlog/fmt/fmt.h>
 
 using namespace llvm;
 
 static constexpr auto AsmFunctionName = "__omvll_asm_func";
 
-namespace llvm {
-namespace object {
-class MachOObjectFile;
-} // end namespace object
-} // end namespace llvm
-
 namespace omvll {
 
-bool Jitter::HasArchTargetInitialized = false;
+// Jitters are only created through Jitter::get(), once per target triple for
+// the whole process: modules sharing a triple (e.g. LTO or Swift WMO) reuse the
+// initialized targets and context.
+static std::mutex JittersMutex;
+static std::map<std::string, std::unique_ptr<Jitter>> Jitters;
+
+Jitter &Jitter::get(const std::string &Triple) {
+  std::lock_guard<std::mutex> Lock(JittersMutex);
+  std::unique_ptr<Jitter> &JIT = Jitters[Triple];
+  if (!JIT)
+    JIT.reset(new Jitter(Triple));
+  return *JIT;
+}
 
-Jitter::Jitter(const std::string &Triple)
-    : Triple{Triple}, Ctx{new LLVMContext{}} {
+Jitter::Jitter(const std::string &Triple) : Triple{Triple} {
   InitializeNativeTarget();
   InitializeNativeTargetAsmParser();
   InitializeNativeTargetAsmPrinter();
@@ -56,19 +68,19 @@ Jitter::Jitter(const std::string &Triple)
 }
 
 void Jitter::initializeArchTarget() {
-  if (!HasArchTargetInitialized) {
-    llvm::Triple TT(Triple);
-    if (TT.isARM() || TT.isThumb())
-      initializeARMAssembler();
-    else if (TT.isAArch64())
-      initializeAArch64Assembler();
-    else if (TT.isX86())
-      initializeX86Assembler();
-    else
-      fatalError(fmt::format("Unsupported arch type: {}",
-                             Triple::getArchTypeName(TT.getArch())));
-    HasArchTargetInitialized = true;
-  }
+  // Each architecture must be registered once, even when several triples of
+  // different architectures are used in the same process.
+  static std::once_flag ARMInitialized, AArch64Initialized, X86Initialized;
+  llvm::Triple TT(Triple);
+  if (TT.isARM() || TT.isThumb())
+    std::call_once(ARMInitialized, initializeARMAssembler);
+  else if (TT.isAArch64())
+    std::call_once(AArch64Initialized, initializeAArch64Assembler);
+  else if (TT.isX86())
+    std::call_once(X86Initialized, initializeX86Assembler);
+  else
+    fatalError(fmt::format("Unsupported arch type: {}",
+                           Triple::getArchTypeName(TT.getArch())));
 }
 
 void Jitter::initializeARMAssembler() {
@@ -95,113 +107,120 @@ void Jitter::initializeX86Assembler() {
   LLVMInitializeX86AsmPrinter();
 }
 
-std::unique_ptr<orc::LLJIT> Jitter::compile(Module &M) {
-  static ExitOnError ExitOnErr;
-  auto JITB = ExitOnErr(orc::LLJITBuilder().create());
-  std::unique_ptr<Module> ClonedM = CloneModule(M);
-  auto Context = std::make_unique<LLVMContext>();
-
-  ExitOnErr(JITB->addIRModule(
-      orc::ThreadSafeModule(std::move(ClonedM), std::move(Context))));
-  return JITB;
-}
-
-size_t Jitter::getFunctionSize(object::ObjectFile &Obj, StringRef Name) {
-  if (auto *ELF = dyn_cast<object::ELFObjectFileBase>(&Obj)) {
-    for (const object::ELFSymbolRef &Sym : ELF->symbols()) {
-      if (Sym.getELFType() != ELF::STT_FUNC)
-        continue;
-      if (auto Str = Sym.getName())
-        if (*Str == Name)
-          return Sym.getSize();
+StringRef Jitter::getFunctionBytes(object::ObjectFile &Obj, StringRef Name) {
+  for (const object::SymbolRef &Sym : Obj.symbols()) {
+    Expected<StringRef> SymName = Sym.getName();
+    if (!SymName) {
+      consumeError(SymName.takeError());
+      continue;
     }
-    fatalError("jitAsm: Unable to find symbol " + Name.str());
+    if (*SymName != Name)
+      continue;
+
+    Expected<object::section_iterator> Sec = Sym.getSection();
+    if (!Sec)
+      fatalError("jitAsm: " + toString(Sec.takeError()));
+    Expected<uint64_t> Addr = Sym.getAddress();
+    if (!Addr)
+      fatalError("jitAsm: " + toString(Addr.takeError()));
+    if (*Sec == Obj.section_end())
+      break;
+
+    Expected<StringRef> Contents = (*Sec)->getContents();
+    if (!Contents)
+      fatalError("jitAsm: " + toString(Contents.takeError()));
+
+    // The snippet is the only content of its section: the function spans from
+    // the symbol up to the end of the section, whatever the object format.
+    uint64_t Offset = *Addr - (*Sec)->getAddress();
+    uint64_t Size = Contents->size() - Offset;
+    if (isa<object::ELFObjectFileBase>(&Obj))
+      if (uint64_t ELFSize = object::ELFSymbolRef(Sym).getSize())
+        Size = ELFSize;
+    return Contents->substr(Offset, Size);
   }
 
-#if 0
-  if (auto *MachO = dyn_cast<object::MachOObjectFile>(&Obj)) {
-    for (const object::SymbolRef Sym : MachO->symbols()) {
-      object::DataRefImpl Impl = Sym.getRawDataRefImpl();
-      if (auto SName = MachO->getSymbolName(Impl)) {
-        if (*SName != Name)
-          continue;
-      }
-      if (auto ItSec = MachO->getSymbolSection(Impl)) {
-        uint64_t Size = (*ItSec)->getSize();
-        return Size;
-      }
-    }
-    fatalError("jitAsm: Unable to find symbol '" + Name.str() + "'");
-  }
-#endif
-
-  fatalError("jitAsm: Unsupported file format");
+  fatalError("jitAsm: Unable to find symbol " + Name.str());
 }
 
-std::unique_ptr<MemoryBuffer> Jitter::jitAsm(const std::string &Asm,
-                                             size_t Size) {
-  static ExitOnError ExitOnErr;
+std::unique_ptr<MemoryBuffer> Jitter::jitAsm(const std::string &Asm) {
+  std::lock_guard<std::mutex> Lock(Mutex);
 
-  auto Context = std::make_unique<LLVMContext>();
-  auto M = std::make_unique<Module>("__omvll_asm_jit", *Context);
+  // Assemble the snippet straight into an in-memory object file with the MC
+  // layer, with no IR, codegen nor JIT linking involved.
+  llvm::Triple TT(Triple);
+  std::string Error;
+  const Target *T = TargetRegistry::lookupTarget(Triple, Error);
+  if (!T)
+    fatalError("jitAsm: " + Error);
 
-  Function *F =
-      Function::Create(FunctionType::get(Type::getVoidTy(*Context), {}, false),
-                       Function::ExternalLinkage, AsmFunctionName, M.get());
-
-  BasicBlock *BB = BasicBlock::Create(*Context, "EntryBlock", F);
-  IRBuilder<> IRB(BB);
-
-  auto *FType = FunctionType::get(IRB.getVoidTy(), false);
-  InlineAsm *RawAsm = InlineAsm::get(FType, Asm, "", /* hasSideEffects */ true,
-                                     /* isStackAligned */ true);
-  IRB.CreateCall(FType, RawAsm);
-  IRB.CreateRetVoid();
+#if LLVM_VERSION_MAJOR >= 21
+  const llvm::Triple &TargetTriple = TT;
+#else
+  const std::string &TargetTriple = Triple;
+#endif
 
-  orc::LLJITBuilder Builder;
-  std::string TT = Triple;
-  orc::JITTargetMachineBuilder JTMB{llvm::Triple(TT)};
-  JTMB.setRelocationModel(Reloc::Model::PIC_);
-  JTMB.setCodeModel(CodeModel::Large);
+  MCTargetOptions MCOptions;
+  std::unique_ptr<MCRegisterInfo> MRI(T->createMCRegInfo(TargetTriple));
+  std::unique_ptr<MCAsmInfo> MAI(
+      T->createMCAsmInfo(*MRI, TargetTriple, MCOptions));
+  std::unique_ptr<MCSubtargetInfo> STI(
+      T->createMCSubtargetInfo(TargetTriple, "", ""));
+  std::unique_ptr<MCInstrInfo> MII(T->createMCInstrInfo());
+  if (!MRI || !MAI || !STI || !MII)
+    fatalError("jitAsm: Unable to create the MC layer for " + Triple);
+
+  std::string Source = fmt::format("{}:\n{}\n", AsmFunctionName, Asm);
+  SourceMgr SrcMgr;
+  SrcMgr.AddNewSourceBuffer(MemoryBuffer::getMemBufferCopy(Source), SMLoc());
+
+  MCContext MCCtx(TT, MAI.get(), MRI.get(), STI.get(), &SrcMgr, &MCOptions);
+  std::unique_ptr<MCObjectFileInfo> MOFI(
+      T->createMCObjectFileInfo(MCCtx, /* PIC */ true));
+  MCCtx.setObjectFileInfo(MOFI.get());
+
+  SmallVector<char, 0> Object;
+  raw_svector_ostream OS(Object);
+  std::unique_ptr<MCAsmBackend> MAB(
+      T->createMCAsmBackend(*STI, *MRI, MCOptions));
+  std::unique_ptr<MCCodeEmitter> MCE(T->createMCCodeEmitter(*MII, MCCtx));
+  if (!MAB || !MCE)
+    fatalError("jitAsm: Unable to create the MC layer for " + Triple);
+
+  std::unique_ptr<MCObjectWriter> MOW = MAB->createObjectWriter(OS);
 #if LLVM_VERSION_MAJOR > 18
-  JTMB.setCodeGenOptLevel(CodeGenOptLevel::None);
+  std::unique_ptr<MCStreamer> Streamer(T->createMCObjectStreamer(
+      TT, MCCtx, std::move(MAB), std::move(MOW), std::move(MCE), *STI));
 #else
-  JTMB.setCodeGenOptLevel(CodeGenOpt::Level::None);
-#endif
-  Builder.setPlatformSetUp(orc::setUpInactivePlatform)
-      .setJITTargetMachineBuilder(JTMB);
-  Builder.setJITTargetMachineBuilder(std::move(JTMB));
-
-  std::unique_ptr<orc::LLJIT> JITB = ExitOnErr(Builder.create());
-  if (!JITB)
-    fatalError("JITB is null");
-
-  M->setDataLayout(JITB->getDataLayout());
-
-  auto &IRC = JITB->getIRCompileLayer();
-  orc::IRCompileLayer::IRCompiler &Compiler = IRC.getCompiler();
-  if (auto Res = Compiler(*M)) {
-    std::unique_ptr<MemoryBuffer> Buff = std::move(*Res);
-    size_t FunSize = Size * /* Sizeof AArch64 inst=*/4;
-
-#if 0
-    if (auto E = object::ObjectFile::createObjectFile(*Buff)) {
-      std::unique_ptr<object::ObjectFile> Obj = std::move(E.get());
-      FunSize = getFunctionSize(*Obj, AsmFunctionName);
-    }
+  std::unique_ptr<MCStreamer> Streamer(T->createMCObjectStreamer(
+      TT, MCCtx, std::move(MAB), std::move(MOW), std::move(MCE), *STI,
+      /* RelaxAll */ false, /* IncrementalLinkerCompatible */ false,
+      /* DWARFMustBeAtTheEnd */ false));
 #endif
 
-    if (FunSize == 0)
-      fatalError("Cannot retrieve function size");
-
-    ExitOnErr(JITB->addObjectFile(std::move(Buff)));
-    if (auto L = JITB->lookup(AsmFunctionName)) {
-      auto *Ptr = reinterpret_cast<const char *>(L->getValue());
-      return MemoryBuffer::getMemBufferCopy({Ptr, FunSize});
-    }
-  }
-
-  fatalError("Cannot compile " + Asm);
+  std::unique_ptr<MCAsmParser> Parser(
+      createMCAsmParser(SrcMgr, MCCtx, *Streamer, *MAI));
+  std::unique_ptr<MCTargetAsmParser> TAP(
+      T->createMCAsmParser(*STI, *Parser, *MII, MCOptions));
+  if (!TAP)
+    fatalError("jitAsm: Unable to create the assembly parser for " + Triple);
+
+  Parser->setTargetParser(*TAP);
+  if (Parser->Run(/* NoInitialTextSection */ false))
+    fatalError("Cannot assemble " + Asm);
+
+  MemoryBufferRef ObjectRef(StringRef(Object.data(), Object.size()),
+                            AsmFunctionName);
+  Expected<std::unique_ptr<object::ObjectFile>> Obj =
+      object::ObjectFile::createObjectFile(ObjectRef);
+  if (!Obj)
+    fatalError("jitAsm: " + toString(Obj.takeError()));
+
+  StringRef Bytes = getFunctionBytes(**Obj, AsmFunctionName);
+  if (Bytes.empty())
+    fatalError("Cannot retrieve function size");
+
+  return MemoryBuffer::getMemBufferCopy(Bytes);
 }
 
 } // end namespace omvll
@@ -21,6 +21,12 @@ void initDefaultConfig() {
   Config.GlobalModuleExclude.clear();
   Config.GlobalFunctionExclude.clear();
   Config.ProbabilitySeed = 1;
+  Config.PerFunctionSeeds = false;
+  Config.FuseFunctionPasses = false;
+  Config.FunctionPassThreads = 0;
+  Config.ThinLTOPostLink = false;
+  Config.SkipObfuscatedFunctions = true;
+  Config.IncrementalCache = false;
   Config.OutputFolder = "";
 }
 
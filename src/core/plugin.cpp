@@ -4,6 +4,7 @@
 //
 
 #include <dlfcn.h>
+#include <utility>
 
 #include "llvm/Passes/PassBuilder.h"
 #include "llvm/Passes/PassPlugin.h"
@@ -24,9 +25,11 @@ using namespace llvm;
 
 // LLVM 20 added a ThinOrFullLTOPhase parameter to the EP callback signatures.
 #if LLVM_VERSION_MAJOR >= 20
-#define OMVLL_EP_CALLBACK_LTO_ARG , ThinOrFullLTOPhase
+#define OMVLL_EP_CALLBACK_LTO_ARG , ThinOrFullLTOPhase LTOPhase
+#define OMVLL_EP_CALLBACK_LTO_PHASE LTOPhase
 #else
 #define OMVLL_EP_CALLBACK_LTO_ARG
+#define OMVLL_EP_CALLBACK_LTO_PHASE ThinOrFullLTOPhase::None
 #endif
 
 static llvm::once_flag InitializePluginFlag;
@@ -71,11 +74,67 @@ static const std::vector<std::pair<std::string, PassFactory>> &getPassRegistry()
   return Registry;
 }
 
-static void addPassesForPhase(ModulePassManager &MPM, omvll::Phase P) {
+using GroupFactory = std::function<void(omvll::FunctionPassGroup &)>;
+
+// Function-local passes of the registry that can share a FunctionPassGroup.
+static const StringMap<GroupFactory> &getGroupablePasses() {
+  static const StringMap<GroupFactory> Groupable = {
+      {omvll::OpaqueConstants::name(),
+       [](omvll::FunctionPassGroup &G) { G.addPass(omvll::OpaqueConstants()); }},
+      {omvll::Arithmetic::name(),
+       [](omvll::FunctionPassGroup &G) { G.addPass(omvll::Arithmetic()); }},
+      {omvll::IndirectCall::name(),
+       [](omvll::FunctionPassGroup &G) { G.addPass(omvll::IndirectCall()); }},
+      {omvll::IndirectBranch::name(),
+       [](omvll::FunctionPassGroup &G) { G.addPass(omvll::IndirectBranch()); }},
+  };
+  return Groupable;
+}
+
+// With ThinLTO, the EP callbacks run both in the per-TU pre-link pipeline and
+// in the backend post-link one: the modules are obfuscated in one of them.
+static bool shouldObfuscateInLTOPhase(ThinOrFullLTOPhase LTOPhase) {
+  switch (LTOPhase) {
+  case ThinOrFullLTOPhase::ThinLTOPreLink:
+    return !omvll::Config.ThinLTOPostLink;
+  case ThinOrFullLTOPhase::ThinLTOPostLink:
+    return omvll::Config.ThinLTOPostLink;
+  default:
+    return true;
+  }
+}
+
+static void addPassesForPhase(ModulePassManager &OuterMPM, omvll::Phase P,
+                              ThinOrFullLTOPhase LTOPhase) {
+  if (!shouldObfuscateInLTOPhase(LTOPhase))
+    return;
+
+  // Consecutive groupable passes are added as a single FunctionPassGroup,
+  // which can fuse their walks over the functions of the module.
+  ModulePassManager MPM;
+  omvll::FunctionPassGroup Group;
+  auto FlushGroup = [&]() {
+    if (!Group.empty())
+      MPM.addPass(std::exchange(Group, omvll::FunctionPassGroup()));
+  };
+
   for (const auto &[Name, Factory] : getPassRegistry()) {
-    if (omvll::hasPhase(Name, P))
-      Factory(MPM);
+    if (!omvll::hasPhase(Name, P))
+      continue;
+
+    auto It = getGroupablePasses().find(Name);
+    if (It != getGroupablePasses().end()) {
+      It->second(Group);
+      continue;
+    }
+
+    FlushGroup();
+    Factory(MPM);
   }
+  FlushGroup();
+
+  if (!MPM.isEmpty())
+    OuterMPM.addPass(omvll::PhaseGuard(std::move(MPM), P));
 }
 
 template <> struct yaml::MappingTraits<omvll::YamlConfig> {
@@ -180,13 +239,15 @@ PassPluginLibraryInfo getOMVLLPluginInfo() {
                   [](ModulePassManager &MPM, OptimizationLevel
                          OMVLL_EP_CALLBACK_LTO_ARG) {
                     MPM.addPass(omvll::LoggerBind());
-                    addPassesForPhase(MPM, omvll::Phase::Early);
+                    addPassesForPhase(MPM, omvll::Phase::Early,
+                                      OMVLL_EP_CALLBACK_LTO_PHASE);
                     return true;
                   });
               PB.registerOptimizerLastEPCallback(
                   [](ModulePassManager &MPM, OptimizationLevel
                          OMVLL_EP_CALLBACK_LTO_ARG) {
-                    addPassesForPhase(MPM, omvll::Phase::Last);
+                    addPassesForPhase(MPM, omvll::Phase::Last,
+                                      OMVLL_EP_CALLBACK_LTO_PHASE);
                     return true;
                   });
             } catch (const std::exception &Exc) {
@@ -196,6 +257,7 @@ PassPluginLibraryInfo getOMVLLPluginInfo() {
 }
 
 #undef OMVLL_EP_CALLBACK_LTO_ARG
+#undef OMVLL_EP_CALLBACK_LTO_PHASE
 
 __attribute__((visibility("default")))
 extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo
@@ -176,6 +176,104 @@ void OMVLLCtor(py::module_ &m) {
                     The default value is 1.
                     )delim")
 
+      .def_readwrite("per_function_seeds", &OMVLLConfig::PerFunctionSeeds,
+                     R"delim(
+                    Whether each function gets its own random stream, derived from :attr:`probability_seed`
+                    and the name of the function.
+
+                    The obfuscation of a function then no longer depends on the other functions of the module,
+                    nor on the order in which they are processed.
+
+                    The default value is ``False``.
+                    )delim")
+
+      .def_readwrite("fuse_function_passes", &OMVLLConfig::FuseFunctionPasses,
+                     R"delim(
+                    Whether consecutive function-local passes (:class:`~omvll.Pass` ``OpaqueConstants``,
+                    ``Arithmetic``, ``IndirectCall`` and ``IndirectBranch``) run in a single walk over the
+                    functions of the module rather than one after the other.
+
+                    Each function goes through the passes in the same order, but while it is still hot in cache.
+                    Combined with :attr:`per_function_seeds`, the output is the same as without fusion.
+                    This setting is ignored when :meth:`omvll.ObfuscationConfig.report_diff` is overridden.
+
+                    The default value is ``False``.
+                    )delim")
+
+      .def_readwrite("function_pass_threads", &OMVLLConfig::FunctionPassThreads,
+                     R"delim(
+                    Number of threads running ``OpaqueConstants`` and ``Arithmetic`` over the functions of a
+                    module, 0 or 1 meaning the current thread only.
+
+                    The functions are split into shards, copied into a module and a ``LLVMContext`` per thread,
+                    then copied back once obfuscated. The :class:`omvll.ObfuscationConfig` callbacks of these
+                    passes are called for every function beforehand, on the current thread.
+                    Functions with debug info or taking the address of their blocks are obfuscated on the
+                    current thread: as every function has debug info with ``-g``, such builds do not benefit
+                    from this option. ``IndirectCall`` and ``IndirectBranch`` change module-wide tables: they
+                    run afterwards, on the current thread.
+
+                    The threads are created once, on first use, and each shard goes to its thread and back as
+                    bitcode: small modules may be faster on the current thread.
+
+                    It requires :attr:`per_function_seeds`, so that the output does not depend on the number of
+                    threads, and is ignored when :meth:`omvll.ObfuscationConfig.report_diff` is overridden.
+
+                    The default value is 0.
+                    )delim")
+
+      .def_readwrite("thinlto_post_link", &OMVLLConfig::ThinLTOPostLink,
+                     R"delim(
+                    With ThinLTO, whether the modules are obfuscated in the post-link (backend) pipeline
+                    rather than in the pre-link (per-TU) one.
+
+                    Post-link obfuscation runs in the parallel ThinLTO backends, after cross-module importing,
+                    so that imported functions are obfuscated along with the rest of the module.
+                    A module already obfuscated in a phase is never obfuscated again in this phase.
+
+                    This value is read when the pipeline is built, so it must be set when the configuration
+                    is imported (like :attr:`pass_phases`), not in :meth:`omvll.ObfuscationConfig` callbacks.
+                    It only has an effect with LLVM 20 and later.
+
+                    The default value is ``False``.
+                    )delim")
+
+      .def_readwrite("skip_obfuscated_functions", &OMVLLConfig::SkipObfuscatedFunctions,
+                     R"delim(
+                    Whether a pass skips the functions it already obfuscated with the same parameters.
+
+                    The passes record in the ``!omvll.passes`` metadata of a function the parameters they
+                    obfuscated it with. When a pass runs in both :attr:`~omvll.Phase.Early` and
+                    :attr:`~omvll.Phase.Last`, or when a module is optimized again, the code it produced is
+                    then not transformed a second time.
+
+                    The default value is ``True``.
+                    )delim")
+
+      .def_readwrite("incremental_cache", &OMVLLConfig::IncrementalCache,
+                     R"delim(
+                    Whether the function-local passes (:class:`~omvll.Pass` ``OpaqueConstants``,
+                    ``Arithmetic``, ``IndirectCall`` and ``IndirectBranch``) reuse the functions they
+                    obfuscated in a previous build.
+
+                    The obfuscated functions are stored as bitcode in the ``cache/functions`` directory of
+                    :attr:`output_folder`. They are keyed by the IR of the function before obfuscation,
+                    the content of the configuration file, :attr:`probability_seed` and the passes that run.
+                    Modules imported by the configuration file are not part of the key: clear the directory
+                    when they change.
+
+                    This setting requires :attr:`output_folder` and :attr:`per_function_seeds`, and is
+                    ignored when :meth:`omvll.ObfuscationConfig.report_diff` is overridden.
+                    Functions with debug info are not cached.
+
+                    Only the functions that, once obfuscated, refer to globals that existed before the
+                    passes ran are cached. This rules out the functions rewritten by ``IndirectCall``
+                    and ``IndirectBranch``, which refer to the tables they create: in practice, only the
+                    output of ``OpaqueConstants`` and ``Arithmetic`` is reused.
+
+                    The default value is ``False``.
+                    )delim")
+
       .def_readwrite("output_folder", &OMVLLConfig::OutputFolder,
                      R"delim(
                     Output directory where o-mvll stores processed files (e.g., log files).
@@ -441,7 +539,21 @@ PyConfig &PyConfig::instance() {
   return Instance;
 }
 
+thread_local ObfuscationConfig *PyConfig::ThreadConfig = nullptr;
+
+PyConfig::ThreadOverride::ThreadOverride(ObfuscationConfig *Override)
+    : Previous(PyConfig::ThreadConfig) {
+  PyConfig::ThreadConfig = Override;
+}
+
+PyConfig::ThreadOverride::~ThreadOverride() {
+  PyConfig::ThreadConfig = Previous;
+}
+
 ObfuscationConfig *PyConfig::getUserConfig() {
+  if (ThreadConfig)
+    return ThreadConfig;
+
   try {
     py::gil_scoped_acquire gil;
     if (!py::hasattr(*Mod, "omvll_get_config"))
@@ -90,8 +90,16 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     Option for the :meth:`omvll.ObfuscationConfig.break_control_flow` protection.
 
     This boolean option determines whether the protection must be enabled (e.g. ``BreakControlFlowOpt(True)``)
+
+    With ``splice_body=True``, the body of the protected function is moved into the new internal
+    function instead of being cloned, which lowers the compile time and peak memory on large functions.
+    The generated code is the same.
+
+    With ``tail_call=True``, the trampoline tail-calls the protected function whenever it is legal,
+    such that it compiles down to a direct branch and does not keep an extra frame for each call.
     )delim")
-    .def(py::init<bool>());
+    .def(py::init<bool, bool, bool>(), "value"_a, "splice_body"_a = false,
+         "tail_call"_a = false);
 
   // CFG Flattening
   py::class_<ControlFlowFlatteningOpt>(m, "ControlFlowFlatteningOpt",
@@ -130,8 +138,18 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     This option defines lower limit from which constants must be obfuscated (e.g. ``OpaqueConstantsLowerLimit(100)``).
     An optional ``arith_rounds`` parameter controls how many rounds of arithmetic obfuscation
     are applied to the generated opaque expressions (e.g. ``OpaqueConstantsLowerLimit(100, arith_rounds=2)``).
+    With ``register_seeds=True``, the opaque expressions derive from values kept in registers
+    rather than from volatile loads of stack slots, which lowers their runtime cost.
+    Each expression is drawn from a library of distinct generators. A non-zero ``latency_budget`` restricts
+    the draw to the generators whose estimated cycles still fit within the budget of the function: once it is
+    spent, the constants get the cheapest generator.
+    With ``reuse_factor=N``, up to N uses of a constant within a basic block share the same opaque expression.
+    By default (``hoist_from_loops=True``), the opaque constants of a loop are computed once in its preheader.
     )delim")
-    .def(py::init<uint64_t, uint8_t>(), "limit"_a, "arith_rounds"_a = 0);
+    .def(py::init<uint64_t, uint8_t, bool, uint32_t, uint32_t, bool>(), "limit"_a,
+         "arith_rounds"_a = 0, "register_seeds"_a = false,
+         "latency_budget"_a = 0, "reuse_factor"_a = 0,
+         "hoist_from_loops"_a = true);
 
   py::class_<OpaqueConstantsBool>(m, "OpaqueConstantsBool",
     R"delim(
@@ -141,8 +159,18 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     the constants are not protected otherwise, **all** the constants are protected.
     An optional ``arith_rounds`` parameter controls how many rounds of arithmetic obfuscation
     are applied to the generated opaque expressions (e.g. ``OpaqueConstantsBool(True, arith_rounds=2)``).
+    With ``register_seeds=True``, the opaque expressions derive from values kept in registers
+    rather than from volatile loads of stack slots, which lowers their runtime cost.
+    Each expression is drawn from a library of distinct generators. A non-zero ``latency_budget`` restricts
+    the draw to the generators whose estimated cycles still fit within the budget of the function: once it is
+    spent, the constants get the cheapest generator.
+    With ``reuse_factor=N``, up to N uses of a constant within a basic block share the same opaque expression.
+    By default (``hoist_from_loops=True``), the opaque constants of a loop are computed once in its preheader.
     )delim")
-    .def(py::init<bool, uint8_t>(), "value"_a, "arith_rounds"_a = 0);
+    .def(py::init<bool, uint8_t, bool, uint32_t, uint32_t, bool>(), "value"_a,
+         "arith_rounds"_a = 0, "register_seeds"_a = false,
+         "latency_budget"_a = 0, "reuse_factor"_a = 0,
+         "hoist_from_loops"_a = true);
 
   py::class_<OpaqueConstantsSkip>(m, "OpaqueConstantsSkip",
     R"delim(
@@ -160,8 +188,18 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     (e.g. ``OpaqueConstantsSet([0x12234, 1, 2])``).
     An optional ``arith_rounds`` parameter controls how many rounds of arithmetic obfuscation
     are applied to the generated opaque expressions (e.g. ``OpaqueConstantsSet([1, 2], arith_rounds=2)``).
+    With ``register_seeds=True``, the opaque expressions derive from values kept in registers
+    rather than from volatile loads of stack slots, which lowers their runtime cost.
+    Each expression is drawn from a library of distinct generators. A non-zero ``latency_budget`` restricts
+    the draw to the generators whose estimated cycles still fit within the budget of the function: once it is
+    spent, the constants get the cheapest generator.
+    With ``reuse_factor=N``, up to N uses of a constant within a basic block share the same opaque expression.
+    By default (``hoist_from_loops=True``), the opaque constants of a loop are computed once in its preheader.
     )delim")
-    .def(py::init<std::vector<uint64_t>, uint8_t>(), "constants"_a, "arith_rounds"_a = 0);
+    .def(py::init<std::vector<uint64_t>, uint8_t, bool, uint32_t, uint32_t, bool>(),
+         "constants"_a, "arith_rounds"_a = 0, "register_seeds"_a = false,
+         "latency_budget"_a = 0, "reuse_factor"_a = 0,
+         "hoist_from_loops"_a = true);
 
   py::class_<OpaqueConstantsExcludeSet>(m, "OpaqueConstantsExcludeSet",
     R"delim(
@@ -171,26 +209,48 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     (e.g. ``OpaqueConstantsExcludeSet([0x12234, 1, 2])``).
     An optional ``arith_rounds`` parameter controls how many rounds of arithmetic obfuscation
     are applied to the generated opaque expressions (e.g. ``OpaqueConstantsExcludeSet([1, 2], arith_rounds=2)``).
+    With ``register_seeds=True``, the opaque expressions derive from values kept in registers
+    rather than from volatile loads of stack slots, which lowers their runtime cost.
+    Each expression is drawn from a library of distinct generators. A non-zero ``latency_budget`` restricts
+    the draw to the generators whose estimated cycles still fit within the budget of the function: once it is
+    spent, the constants get the cheapest generator.
+    With ``reuse_factor=N``, up to N uses of a constant within a basic block share the same opaque expression.
+    By default (``hoist_from_loops=True``), the opaque constants of a loop are computed once in its preheader.
     )delim")
-    .def(py::init<std::vector<uint64_t>, uint8_t>(), "constants"_a, "arith_rounds"_a = 0);
+    .def(py::init<std::vector<uint64_t>, uint8_t, bool, uint32_t, uint32_t, bool>(),
+         "constants"_a, "arith_rounds"_a = 0, "register_seeds"_a = false,
+         "latency_budget"_a = 0, "reuse_factor"_a = 0,
+         "hoist_from_loops"_a = true);
 
   // Indirect Branch
   py::class_<IndirectBranchOpt>(m, "IndirectBranchOpt",
     R"delim(
     Option for the :meth:`omvll.ObfuscationConfig.indirect_branch` protection.
 
-    This option only accepts a boolean value (e.g. ``IndirectBranchOpt(True)``)
+    This option accepts a boolean value (e.g. ``IndirectBranchOpt(True)``).
+    An optional ``merge_tables`` parameter packs the jump tables of all the functions
+    into a single module-wide table, and ``mask_entries`` stores the table entries
+    masked with a per-function key (e.g. ``IndirectBranchOpt(True, merge_tables=True, mask_entries=True)``).
     )delim")
-    .def(py::init<bool>(), "value"_a);
+    .def(py::init([](bool Value, bool MergeTables, bool MaskEntries) {
+           return IndirectBranchOpt(
+               IndirectBranchConfig(Value, MergeTables, MaskEntries));
+         }),
+         "value"_a, "merge_tables"_a = false, "mask_entries"_a = false);
 
   // Indirect Call
   py::class_<IndirectCallOpt>(m, "IndirectCallOpt",
     R"delim(
     Option for the :meth:`omvll.ObfuscationConfig.indirect_call` protection.
 
-    This option only accepts a boolean value (e.g. ``IndirectCallOpt(True)``)
+    This option accepts a boolean value (e.g. ``IndirectCallOpt(True)``).
+    An optional ``hoist_from_loops`` parameter computes the address of the callees
+    called within loops once, in the loop preheader (e.g. ``IndirectCallOpt(True, hoist_from_loops=True)``).
     )delim")
-    .def(py::init<bool>(), "value"_a);
+    .def(py::init([](bool Value, bool HoistFromLoops) {
+           return IndirectCallOpt(IndirectCallConfig(Value, HoistFromLoops));
+         }),
+         "value"_a, "hoist_from_loops"_a = false);
 
   // BasicBlock Duplicate
   py::class_<BasicBlockDuplicateSkip>(m, "BasicBlockDuplicateSkip",
@@ -209,8 +269,14 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     For example, ``BasicBlockDuplicateWithProbability(0)`` implies that the pass never runs,
     whereas ``BasicBlockDuplicateWithProbability(100)`` duplicates all basic blocks in a
     function.
+
+    With ``skip_hot_blocks=True``, hot basic blocks are never duplicated, to limit the runtime
+    and code size overhead. A block is hot when its estimated frequency, weighted by its loop
+    depth and its size, is high: cold paths within loops (e.g., error handling) are still
+    duplicated, whereas large blocks may be skipped even outside of loops. For instance:
+    ``BasicBlockDuplicateWithProbability(50, skip_hot_blocks=True)``.
     )delim")
-    .def(py::init<unsigned>(), "probability"_a);
+    .def(py::init<unsigned, bool>(), "probability"_a, "skip_hot_blocks"_a = false);
 
   // Function Outline
   py::class_<FunctionOutlineSkip>(m, "FunctionOutlineSkip",
@@ -229,8 +295,18 @@ py::module_ &py_init_obf_opt(py::module_ &m) {
     For example, ``FunctionOutlineWithProbability(0)`` implies that the pass never runs,
     whereas ``FunctionOutlineWithProbability(100)`` outlines all the candidate basic blocks
     within a function.
+
+    With ``skip_hot_blocks=True``, hot basic blocks are never outlined, as it would add a call
+    on the hot path. A block is hot when its estimated frequency, weighted by its loop depth
+    and its size, is high: cold paths within loops (e.g., error handling) are still outlined.
+    For instance: ``FunctionOutlineWithProbability(50, skip_hot_blocks=True)``.
+
+    With ``grow_regions=True``, the selected basic blocks are grown into single-entry
+    single-exit regions of up to 8 blocks, whose boundaries minimize the number of inputs
+    and outputs. This yields fewer and larger outlined functions, with a lower call overhead.
     )delim")
-    .def(py::init<unsigned>(), "probability"_a);
+    .def(py::init<unsigned, bool, bool>(), "probability"_a,
+         "skip_hot_blocks"_a = false, "grow_regions"_a = false);
 
   return m;
   // clang-format on
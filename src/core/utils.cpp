@@ -7,6 +7,10 @@
 #include <unistd.h>
 
 #include "llvm/ADT/Hashing.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/InstIterator.h"
@@ -22,6 +26,7 @@
 #include "llvm/Support/Program.h"
 #include "llvm/Support/RandomNumberGenerator.h"
 #include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/xxhash.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 #include "llvm/Transforms/Utils/Cloning.h"
@@ -588,17 +593,56 @@ bool isEHBlock(const BasicBlock &BB) {
   return BB.isEHPad() || BB.isLandingPad();
 }
 
+// A transformation on a block has a fixed runtime overhead (e.g., a coinflip
+// or a call) plus a footprint growing with the size of the block.
+static constexpr double HotBlockOverhead = 8.0;
+// Estimated instructions executed per call of the function above which the
+// overhead of transforming a block would be noticeable.
+static constexpr double HotBlockThreshold = 128.0;
+
+// Collect the basic blocks for which a transformation adding a call or growing
+// the code footprint would be noticeable at runtime. The cost of a block is
+// its frequency relative to the function entry, scaled by its loop depth since
+// static trip count estimates are low, times its overhead and size. Cold paths
+// within loops (e.g., error handling) have a low frequency and are kept.
+SmallPtrSet<const BasicBlock *, 16> findHotBlocks(Function &F) {
+  SmallPtrSet<const BasicBlock *, 16> HotBlocks;
+
+  // As in reg2mem, compute the analyses locally rather than through the FAM.
+  DominatorTree DT(F);
+  LoopInfo LI(DT);
+  BranchProbabilityInfo BPI(F, LI);
+  BlockFrequencyInfo BFI(F, BPI, LI);
+
+  for (BasicBlock &BB : F) {
+    double Freq = BFI.getBlockFreqRelativeToEntryBlock(&BB);
+    double Heat = Freq * (1 + LI.getLoopDepth(&BB));
+    if (Heat * (HotBlockOverhead + BB.size()) >= HotBlockThreshold)
+      HotBlocks.insert(&BB);
+  }
+
+  return HotBlocks;
+}
+
 // Default value is false.
 bool RandomGenerator::Seeded = false;
 std::mt19937_64 RandomGenerator::MtEngine;
+thread_local std::mt19937_64 *RandomGenerator::FunctionEngine = nullptr;
+
+std::mt19937_64 &RandomGenerator::getEngine() {
+  if (RandomGenerator::FunctionEngine)
+    return *RandomGenerator::FunctionEngine;
 
-uint64_t RandomGenerator::generateFullRand() {
   if (!RandomGenerator::Seeded) {
     RandomGenerator::MtEngine.seed(Config.ProbabilitySeed);
     RandomGenerator::Seeded = true;
   }
 
-  return static_cast<uint64_t>(RandomGenerator::MtEngine());
+  return RandomGenerator::MtEngine;
+}
+
+uint64_t RandomGenerator::generateFullRand() {
+  return static_cast<uint64_t>(getEngine()());
 }
 
 // Generate a random number: a <= rnd <= b
@@ -606,14 +650,23 @@ uint64_t RandomGenerator::generateRange(uint64_t a, uint64_t b) {
   if (a > b)
     report_fatal_error("The range for a random must be a <= b.");
 
-  if (!RandomGenerator::Seeded) {
-    RandomGenerator::MtEngine.seed(Config.ProbabilitySeed);
-    RandomGenerator::Seeded = true;
-  }
-
   std::uniform_int_distribution<uint64_t> Distrib(a, b);
 
-  return Distrib(RandomGenerator::MtEngine);
+  return Distrib(getEngine());
+}
+
+RandomGenerator::FunctionStream::FunctionStream(const Function &F)
+    : Previous(RandomGenerator::FunctionEngine) {
+  if (!Config.PerFunctionSeeds)
+    return;
+
+  Engine.seed(static_cast<uint64_t>(Config.ProbabilitySeed) ^
+              xxh3_64bits(F.getName()));
+  RandomGenerator::FunctionEngine = &Engine;
+}
+
+RandomGenerator::FunctionStream::~FunctionStream() {
+  RandomGenerator::FunctionEngine = Previous;
 }
 
 int RandomGenerator::generate() {
@@ -51,6 +51,19 @@ public:
   PyConfig(const PyConfig &) = delete;
   PyConfig &operator=(const PyConfig &) = delete;
 
+  // While alive, getUserConfig() returns Override on the current thread
+  // instead of calling into Python (e.g., on worker threads, which must not).
+  class ThreadOverride {
+  public:
+    ThreadOverride(ObfuscationConfig *Override);
+    ~ThreadOverride();
+    ThreadOverride(const ThreadOverride &) = delete;
+    ThreadOverride &operator=(const ThreadOverride &) = delete;
+
+  private:
+    ObfuscationConfig *Previous;
+  };
+
 private:
   PyConfig();
   ~PyConfig();
@@ -58,6 +71,8 @@ private:
   std::unique_ptr<pybind11::module_> Mod;
   std::unique_ptr<pybind11::module_> CoreMod;
   std::string ModulePath;
+
+  static thread_local ObfuscationConfig *ThreadConfig;
 };
 
 } // end namespace omvll
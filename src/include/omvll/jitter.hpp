@@ -6,21 +6,15 @@
 //
 
 #include <memory>
+#include <mutex>
 #include <string>
 
 #include "llvm/ADT/StringRef.h"
-#include "llvm/Support/Error.h"
 
 // Forward declarations
 namespace llvm {
-class LLVMContext;
-class Module;
 class MemoryBuffer;
 
-namespace orc {
-class LLJIT;
-} // end namespace orc
-
 namespace object {
 class ObjectFile;
 } // end namespace object
@@ -30,29 +24,28 @@ namespace omvll {
 
 class Jitter {
 public:
-  Jitter(const std::string &Triple);
-
-  llvm::LLVMContext &getContext() { return *Ctx; }
+  // Process-wide instance for the given target triple, created on first use.
+  static Jitter &get(const std::string &Triple);
 
-  llvm::Expected<std::unique_ptr<llvm::Module>>
-  loadModule(llvm::StringRef Path, llvm::LLVMContext &Ctx);
+  Jitter(const Jitter &) = delete;
+  Jitter &operator=(const Jitter &) = delete;
 
-  std::unique_ptr<llvm::orc::LLJIT> compile(llvm::Module &M);
-  std::unique_ptr<llvm::MemoryBuffer> jitAsm(const std::string &Asm,
-                                             size_t Size);
+  std::unique_ptr<llvm::MemoryBuffer> jitAsm(const std::string &Asm);
 
 protected:
-  size_t getFunctionSize(llvm::object::ObjectFile &Obj, llvm::StringRef Name);
+  llvm::StringRef getFunctionBytes(llvm::object::ObjectFile &Obj,
+                                   llvm::StringRef Name);
 
 private:
+  Jitter(const std::string &Triple);
+
   std::string Triple;
-  std::unique_ptr<llvm::LLVMContext> Ctx;
+  std::mutex Mutex;
 
-  static bool HasArchTargetInitialized;
   void initializeArchTarget();
-  void initializeARMAssembler();
-  void initializeAArch64Assembler();
-  void initializeX86Assembler();
+  static void initializeARMAssembler();
+  static void initializeAArch64Assembler();
+  static void initializeX86Assembler();
 };
 
 } // end namespace omvll
@@ -70,6 +70,10 @@ public:
   static void set_level(LogLevel L);
 
   static void BindModule(const std::string &Module, const std::string &Arch);
+  // Shares the sink bound on another thread (e.g., with a worker it spawned).
+  static void BindLogger(std::shared_ptr<spdlog::logger> L) {
+    Current = std::move(L);
+  }
   static std::shared_ptr<spdlog::logger> CurrentOrDefault();
 
 private:
@@ -41,6 +41,12 @@ struct OMVLLConfig {
   bool ShuffleFunctions;
   bool InlineJniWrappers;
   int ProbabilitySeed;
+  bool PerFunctionSeeds;
+  bool FuseFunctionPasses;
+  unsigned FunctionPassThreads;
+  bool ThinLTOPostLink;
+  bool SkipObfuscatedFunctions;
+  bool IncrementalCache;
 };
 
 // Defined in omvll_config.cpp.
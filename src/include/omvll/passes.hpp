@@ -5,7 +5,9 @@
 // details.
 //
 
+#include "omvll/passes/FunctionPassGroup.hpp"
 #include "omvll/passes/ObfuscationOpt.hpp"
+#include "omvll/passes/PhaseGuard.hpp"
 #include "omvll/passes/anti-hook/AntiHook.hpp"
 #include "omvll/passes/arithmetic/Arithmetic.hpp"
 #include "omvll/passes/basic-block-duplicate/BasicBlockDuplicate.hpp"
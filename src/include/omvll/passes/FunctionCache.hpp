@@ -0,0 +1,59 @@
+#pragma once
+
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/DenseSet.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+
+// Forward declarations
+namespace llvm {
+class Function;
+class GlobalValue;
+class Module;
+} // end namespace llvm
+
+namespace omvll {
+
+// On-disk cache of obfuscated functions, under <output_folder>/cache/functions.
+// An entry maps the IR of a function before obfuscation, along with the
+// configuration and the passes run on it, to the bitcode of the function once
+// obfuscated. On a hit, the cached body replaces the one of the function,
+// which then skips the passes.
+//
+// A function is only stored when, once obfuscated, it refers to intrinsics or
+// to globals that existed before the passes ran: the cached body can then be
+// spliced back into a later build of the same module. The functions rewritten
+// by IndirectCall or IndirectBranch refer to the tables these passes create,
+// and are never stored.
+class FunctionCache {
+public:
+  FunctionCache(llvm::Module &M, llvm::StringRef PassesID);
+
+  // Whether Config.IncrementalCache is set and usable.
+  static bool isEnabled();
+
+  // Key of F, computed from its IR before obfuscation, if F can be cached.
+  std::optional<uint64_t> getKey(llvm::Function &F);
+
+  bool load(uint64_t Key, llvm::Function &F);
+  void store(uint64_t Key, llvm::Function &F);
+
+private:
+  std::string getEntryPath(uint64_t Key) const;
+
+  llvm::Module &M;
+  llvm::ModuleSlotTracker MST;
+  std::string Dir;
+  // Configuration and module properties that all the keys depend on.
+  std::string Prefix;
+  llvm::DenseSet<const llvm::GlobalValue *> Existing;
+};
+
+} // end namespace omvll
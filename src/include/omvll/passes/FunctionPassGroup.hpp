@@ -0,0 +1,106 @@
+#pragma once
+
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/PassManager.h"
+
+namespace omvll {
+
+struct ObfuscationConfig;
+
+// Module pass running consecutive function-local passes. By default, they run
+// one after the other. With Config.FuseFunctionPasses, they run in a single
+// walk over the functions of the module: each function goes through all the
+// passes, in the same order, while it is still hot in cache. This walk is also
+// used with Config.IncrementalCache, to reuse the functions obfuscated in a
+// previous build (see FunctionCache).
+//
+// A pass of the group exposes the steps of its run() function:
+//   bool beginModule(llvm::Module &M);
+//   bool visitFunction(llvm::Function &F);
+//   bool endModule(llvm::Module &M);
+//
+// A pass that only changes the function it visits may also expose:
+//   static void queryConfig(ObfuscationConfig &UserConfig, llvm::Function &F);
+// With Config.FunctionPassThreads, the leading passes of the group that do
+// run on shards of the functions, each copied into its own LLVMContext and
+// thread, then spliced back into the module (see FunctionTransfer). Their
+// Python callbacks are called beforehand, on the current thread, through
+// queryConfig(), and the threads get the recorded answers.
+struct FunctionPassGroup : llvm::PassInfoMixin<FunctionPassGroup> {
+  llvm::PreservedAnalyses run(llvm::Module &M,
+                              llvm::ModuleAnalysisManager &MAM);
+
+  template <typename PassT> void addPass(PassT Pass) {
+    Passes.push_back(std::make_unique<Model<PassT>>(std::move(Pass)));
+  }
+
+  bool empty() const { return Passes.empty(); }
+
+private:
+  struct Concept {
+    virtual ~Concept() = default;
+    virtual std::unique_ptr<Concept> create() const = 0;
+    virtual bool canRunInParallel() const = 0;
+    virtual void queryConfig(ObfuscationConfig &UserConfig,
+                             llvm::Function &F) = 0;
+    virtual llvm::StringRef name() const = 0;
+    virtual llvm::PreservedAnalyses run(llvm::Module &M,
+                                        llvm::ModuleAnalysisManager &MAM) = 0;
+    virtual bool beginModule(llvm::Module &M) = 0;
+    virtual bool visitFunction(llvm::Function &F) = 0;
+    virtual bool endModule(llvm::Module &M) = 0;
+  };
+
+  template <typename PassT>
+  using QueryConfigT = decltype(PassT::queryConfig(
+      std::declval<ObfuscationConfig &>(), std::declval<llvm::Function &>()));
+
+  template <typename PassT> struct Model final : Concept {
+    Model(PassT Pass) : Pass(std::move(Pass)) {}
+
+    std::unique_ptr<Concept> create() const override {
+      return std::make_unique<Model<PassT>>(PassT());
+    }
+    bool canRunInParallel() const override {
+      return llvm::is_detected<QueryConfigT, PassT>::value;
+    }
+    void queryConfig(ObfuscationConfig &UserConfig,
+                     llvm::Function &F) override {
+      if constexpr (llvm::is_detected<QueryConfigT, PassT>::value)
+        PassT::queryConfig(UserConfig, F);
+    }
+    llvm::StringRef name() const override { return PassT::name(); }
+    llvm::PreservedAnalyses run(llvm::Module &M,
+                                llvm::ModuleAnalysisManager &MAM) override {
+      return Pass.run(M, MAM);
+    }
+    bool beginModule(llvm::Module &M) override { return Pass.beginModule(M); }
+    bool visitFunction(llvm::Function &F) override {
+      return Pass.visitFunction(F);
+    }
+    bool endModule(llvm::Module &M) override { return Pass.endModule(M); }
+
+    PassT Pass;
+  };
+
+  // Runs the first NumPasses passes over Fns on Config.FunctionPassThreads
+  // threads, from a pool kept for the following runs. The contexts cannot
+  // share IR: each shard goes to its thread as bitcode and comes back the same
+  // way, which only pays off on modules with enough code to obfuscate.
+  bool runInParallel(llvm::Module &M, llvm::ArrayRef<llvm::Function *> Fns,
+                     size_t NumPasses);
+
+  std::vector<std::unique_ptr<Concept>> Passes;
+};
+
+} // end namespace omvll
@@ -0,0 +1,85 @@
+#pragma once
+
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include <memory>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Transforms/Utils/ValueMapper.h"
+
+// Forward declarations
+namespace llvm {
+class Constant;
+class Function;
+class GlobalValue;
+class Module;
+class StructType;
+class Type;
+class Value;
+} // end namespace llvm
+
+namespace omvll {
+
+// Global values and identified struct types a function refers to.
+struct FunctionRefs {
+  llvm::SetVector<llvm::GlobalValue *> Globals;
+  llvm::SetVector<llvm::StructType *> Structs;
+  llvm::SmallPtrSet<const llvm::Constant *, 32> Visited;
+
+  void addType(llvm::Type *Ty);
+  void addValue(llvm::Value *V);
+  void addFunction(llvm::Function &F);
+};
+
+// Whether extractFunctions() can copy F: a named definition, without debug
+// info or address-taken blocks, which only refers to named functions and
+// global variables.
+bool isExtractable(llvm::Function &F);
+
+// Builds a module, in the context of Fns, holding copies of Fns along with
+// declarations of the globals they refer to. Once written to bitcode, it can
+// be parsed in another context (e.g., on a worker thread or in a later build)
+// and its functions spliced back with FunctionSplicer.
+std::unique_ptr<llvm::Module>
+extractFunctions(llvm::ArrayRef<llvm::Function *> Fns, llvm::StringRef Name);
+
+// Maps the struct types of an extracted module back to the ones of the module
+// it is spliced into.
+class EntryTypeRemapper : public llvm::ValueMapTypeRemapper {
+public:
+  llvm::Type *remapType(llvm::Type *Ty) override;
+
+  llvm::DenseMap<llvm::Type *, llvm::Type *> Map;
+};
+
+// Replaces the bodies of functions of M with the ones of their namesakes in
+// Entry, a module built by extractFunctions() and parsed in the context of M.
+class FunctionSplicer {
+public:
+  FunctionSplicer(llvm::Module &M, llvm::Module &Entry);
+
+  // Whether the globals and struct types of Entry resolve in M. Nothing is
+  // changed in M otherwise.
+  bool isValid() const { return Valid; }
+
+  bool splice(llvm::Function &F);
+
+private:
+  llvm::Module &M;
+  llvm::Module &Entry;
+  bool Valid = true;
+  EntryTypeRemapper Types;
+  llvm::ValueToValueMapTy VMap;
+  // Intrinsics Entry refers to and M does not declare yet.
+  llvm::SmallVector<llvm::Function *, 4> Intrinsics;
+};
+
+} // end namespace omvll
@@ -10,9 +10,11 @@
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 
 // Forward declarations
 namespace llvm {
+class Function;
 class Instruction;
 } // end namespace llvm
 
@@ -53,4 +55,16 @@ llvm::SmallVector<MetaObf, 5> getObfMetadata(llvm::Instruction &I);
 std::optional<MetaObf> getObf(llvm::Instruction &I, MetaObfTy M);
 bool hasObf(llvm::Instruction &I, MetaObfTy M);
 
+// Stamps recording, in the !omvll.passes metadata of a function, the passes
+// that obfuscated it along with their parameters.
+void addPassStamp(llvm::Function &F, llvm::StringRef Pass,
+                  llvm::StringRef Params = "");
+bool hasPassStamp(const llvm::Function &F, llvm::StringRef Pass,
+                  llvm::StringRef Params = "");
+
+// Whether a pass must skip F since it already obfuscated it with the same
+// parameters, e.g. in an earlier phase (see Config.SkipObfuscatedFunctions).
+bool isAlreadyObfuscated(const llvm::Function &F, llvm::StringRef Pass,
+                         llvm::StringRef Params = "");
+
 } // end namespace omvll
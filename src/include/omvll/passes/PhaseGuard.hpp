@@ -0,0 +1,36 @@
+#pragma once
+
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include "llvm/IR/PassManager.h"
+
+#include "omvll/omvll_config.hpp"
+
+namespace omvll {
+
+// Module pass running the obfuscation passes of a phase, unless the module
+// already went through this phase. The phases a module went through are
+// recorded in the !omvll.obfuscated named metadata, which is serialized along
+// with the bitcode: when a ThinLTO backend, or any later pipeline, gets a
+// module that was obfuscated at pre-link time, it is not obfuscated twice.
+struct PhaseGuard : llvm::PassInfoMixin<PhaseGuard> {
+  PhaseGuard(llvm::ModulePassManager MPM, Phase P)
+      : MPM(std::move(MPM)), P(P) {}
+
+  llvm::PreservedAnalyses run(llvm::Module &M,
+                              llvm::ModuleAnalysisManager &MAM);
+
+  static bool isRequired() { return true; }
+
+  static bool isObfuscated(const llvm::Module &M, Phase P);
+  static void setObfuscated(llvm::Module &M, Phase P);
+
+private:
+  llvm::ModulePassManager MPM;
+  Phase P;
+};
+
+} // end namespace omvll
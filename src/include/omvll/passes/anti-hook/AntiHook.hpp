@@ -14,8 +14,6 @@ class Function;
 
 namespace omvll {
 
-class Jitter;
-
 // Frida Anti-Hooking.
 // See https://obfuscator.re/omvll/passes/anti-hook/ for details.
 struct AntiHook : llvm::PassInfoMixin<AntiHook> {
@@ -25,7 +23,8 @@ struct AntiHook : llvm::PassInfoMixin<AntiHook> {
   bool runOnFunction(llvm::Function &F);
 
 private:
-  std::unique_ptr<Jitter> JIT;
+  std::string getAssembledPrologue(const std::string &Asm,
+                                   const std::string &Triple);
 };
 
 } // end namespace omvll
@@ -24,10 +24,20 @@ class BinaryOperator;
 
 namespace omvll {
 
+struct ObfuscationConfig;
+
 // See https://obfuscator.re/omvll/passes/arithmetic/ for details.
 struct Arithmetic : llvm::PassInfoMixin<Arithmetic> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &FAM);
+
+  // Steps of run(), see FunctionPassGroup.
+  bool beginModule(llvm::Module &) { return false; }
+  bool visitFunction(llvm::Function &F);
+  bool endModule(llvm::Module &) { return false; }
+  // Calls the callbacks of UserConfig visitFunction() would call on F.
+  static void queryConfig(ObfuscationConfig &UserConfig, llvm::Function &F);
+
   bool runOnBasicBlock(llvm::BasicBlock &BB,
                        std::optional<size_t> Rounds = std::nullopt);
   bool runOnFunction(llvm::Function &F,
@@ -5,19 +5,28 @@
 // details.
 //
 
+#include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/PassManager.h"
 
+// Forward declarations
+namespace llvm {
+class AllocaInst;
+} // end namespace llvm
+
 namespace omvll {
 
+struct BasicBlockDuplicateWithProbability;
+
 struct BasicBlockDuplicate : llvm::PassInfoMixin<BasicBlockDuplicate> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &MAM);
 
-  bool process(llvm::Function &F, llvm::LLVMContext &Ctx, unsigned);
+  bool process(llvm::Function &F, llvm::LLVMContext &Ctx,
+               const BasicBlockDuplicateWithProbability &Opt);
 
 private:
-  void initializeCoinflipRoutine(llvm::Module &M);
-  llvm::FunctionCallee CoinflipCallee;
+  llvm::Value *buildCoinflip(llvm::IRBuilder<> &Builder,
+                             llvm::AllocaInst *Slot);
 };
 
 } // end namespace omvll
@@ -12,10 +12,12 @@ namespace omvll {
 struct BasicBlockDuplicateSkip {};
 
 struct BasicBlockDuplicateWithProbability {
-  BasicBlockDuplicateWithProbability(unsigned Probability = 0)
-      : Probability(Probability) {}
+  BasicBlockDuplicateWithProbability(unsigned Probability = 0,
+                                     bool SkipHotBlocks = false)
+      : Probability(Probability), SkipHotBlocks(SkipHotBlocks) {}
   operator bool() const { return Probability > 0; }
   unsigned Probability;
+  bool SkipHotBlocks;
 };
 
 using BasicBlockDuplicateOpt =
@@ -17,15 +17,16 @@ class BasicBlock;
 namespace omvll {
 
 class Jitter;
+struct BreakControlFlowOpt;
 
 // See https://obfuscator.re/omvll/passes/control-flow-breaking/ for details.
 struct BreakControlFlow : llvm::PassInfoMixin<BreakControlFlow> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &FAM);
 
-  bool runOnFunction(llvm::Function &F);
+  bool runOnFunction(llvm::Function &F, const BreakControlFlowOpt &Opt);
 
-  std::unique_ptr<Jitter> JIT;
+  Jitter *JIT = nullptr;
 };
 
 } // end namespace omvll
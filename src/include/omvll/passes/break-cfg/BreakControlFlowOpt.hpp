@@ -8,9 +8,13 @@
 namespace omvll {
 
 struct BreakControlFlowOpt {
-  BreakControlFlowOpt(bool Value) : Value(Value) {}
+  BreakControlFlowOpt(bool Value, bool SpliceBody = false,
+                      bool TailCall = false)
+      : Value(Value), SpliceBody(SpliceBody), TailCall(TailCall) {}
   operator bool() const { return Value; }
   bool Value = false;
+  bool SpliceBody = false;
+  bool TailCall = false;
 };
 
 } // end namespace omvll
@@ -9,11 +9,14 @@
 
 namespace omvll {
 
+struct FunctionOutlineWithProbability;
+
 struct FunctionOutline : llvm::PassInfoMixin<FunctionOutline> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &MAM);
 
-  bool process(llvm::Function &F, llvm::LLVMContext &Ctx, unsigned);
+  bool process(llvm::Function &F, llvm::LLVMContext &Ctx,
+               const FunctionOutlineWithProbability &Opt);
 };
 
 } // end namespace omvll
@@ -12,10 +12,15 @@ namespace omvll {
 struct FunctionOutlineSkip {};
 
 struct FunctionOutlineWithProbability {
-  FunctionOutlineWithProbability(unsigned Probability = 0)
-      : Probability(Probability) {}
+  FunctionOutlineWithProbability(unsigned Probability = 0,
+                                 bool SkipHotBlocks = false,
+                                 bool GrowRegions = false)
+      : Probability(Probability), SkipHotBlocks(SkipHotBlocks),
+        GrowRegions(GrowRegions) {}
   operator bool() const { return Probability > 0; }
   unsigned Probability;
+  bool SkipHotBlocks;
+  bool GrowRegions;
 };
 
 using FunctionOutlineOpt =
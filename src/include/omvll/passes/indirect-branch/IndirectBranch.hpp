@@ -5,19 +5,38 @@
 // details.
 //
 
+#include <vector>
+
 #include "llvm/IR/PassManager.h"
 
+// Forward declarations
+namespace llvm {
+class GlobalVariable;
+} // end namespace llvm
+
 namespace omvll {
 
+struct IndirectBranchConfig;
+
 struct IndirectBranch : llvm::PassInfoMixin<IndirectBranch> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &MAM);
 
+  // Steps of run(), see FunctionPassGroup. The jump tables of all the
+  // functions are merged by endModule().
+  bool beginModule(llvm::Module &M);
+  bool visitFunction(llvm::Function &F);
+  bool endModule(llvm::Module &M);
+
   bool process(llvm::Function &F, const llvm::DataLayout &DL,
-               llvm::LLVMContext &Ctx);
+               llvm::LLVMContext &Ctx, const IndirectBranchConfig &Opt,
+               unsigned ShuffleSeed);
 
 private:
+  // Seed of the shuffle of the jump tables without per-function seeds.
   unsigned Seed = 0;
+  std::vector<llvm::GlobalVariable *> TablesToMerge;
+  std::vector<llvm::GlobalVariable *> MaskedTablesToMerge;
 };
 
 } // end namespace omvll
@@ -10,9 +10,13 @@
 namespace omvll {
 
 struct IndirectBranchConfig {
-  IndirectBranchConfig(bool Value) : Value(Value) {}
+  IndirectBranchConfig(bool Value, bool MergeTables = false,
+                       bool MaskEntries = false)
+      : Value(Value), MergeTables(MergeTables), MaskEntries(MaskEntries) {}
   operator bool() const { return Value; }
   bool Value = false;
+  bool MergeTables = false;
+  bool MaskEntries = false;
 };
 
 using IndirectBranchOpt = std::optional<IndirectBranchConfig>;
@@ -5,16 +5,49 @@
 // details.
 //
 
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/PassManager.h"
 
+#include "omvll/passes/indirect-call/IndirectCallOpt.hpp"
+
+// Forward declarations
+namespace llvm {
+class CallInst;
+class GlobalVariable;
+} // end namespace llvm
+
 namespace omvll {
 
 struct IndirectCall : llvm::PassInfoMixin<IndirectCall> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &MAM);
 
+  // Steps of run(), see FunctionPassGroup. The call-sites of all the functions
+  // are collected by beginModule() to create the shares tables.
+  bool beginModule(llvm::Module &M);
+  bool visitFunction(llvm::Function &F);
+  bool endModule(llvm::Module &M);
+
   bool process(llvm::Function &F, const llvm::DataLayout &DL,
-               llvm::LLVMContext &Ctx);
+               llvm::LLVMContext &Ctx,
+               llvm::ArrayRef<llvm::CallInst *> DirectCalls,
+               const IndirectCallConfig &Opt);
+
+private:
+  void createShareTables(llvm::Module &M,
+                         llvm::ArrayRef<llvm::Function *> Callees);
+
+  struct FunctionCallSites {
+    IndirectCallConfig Opt;
+    llvm::SmallVector<llvm::CallInst *, 32> DirectCalls;
+  };
+
+  llvm::DenseMap<llvm::Function *, FunctionCallSites> CallSites;
+  llvm::DenseMap<llvm::Function *, unsigned> CalleeToIdx;
+  llvm::GlobalVariable *GVAddrShares1 = nullptr;
+  llvm::GlobalVariable *GVAddrShares2 = nullptr;
 };
 
 } // end namespace omvll
@@ -10,9 +10,11 @@
 namespace omvll {
 
 struct IndirectCallConfig {
-  IndirectCallConfig(bool Value) : Value(Value) {}
+  IndirectCallConfig(bool Value, bool HoistFromLoops = false)
+      : Value(Value), HoistFromLoops(HoistFromLoops) {}
   operator bool() const { return Value; }
   bool Value = false;
+  bool HoistFromLoops = false;
 };
 
 using IndirectCallOpt = std::optional<IndirectCallConfig>;
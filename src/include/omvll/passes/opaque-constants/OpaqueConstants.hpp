@@ -5,6 +5,8 @@
 // details.
 //
 
+#include <optional>
+
 #include "llvm/IR/PassManager.h"
 #include "llvm/ADT/DenseMap.h"
 
@@ -23,20 +25,45 @@ class Type;
 
 namespace omvll {
 
+struct ObfuscationConfig;
+
 struct OpaqueContext {
-  llvm::AllocaInst *T1;
-  llvm::AllocaInst *T2;
+  llvm::AllocaInst *T1 = nullptr;
+  llvm::AllocaInst *T2 = nullptr;
+  // Register-resident seeds, used instead of T1/T2 when set.
+  llvm::Value *S1 = nullptr;
+  llvm::Value *S2 = nullptr;
+  // Remaining latency budget of the function, if any.
+  std::optional<uint32_t> LatencyBudget;
+  // Opaque expressions shared by the uses of a constant within a block,
+  // along with the number of uses left.
+  uint32_t ReuseFactor = 0;
+  llvm::DenseMap<std::pair<llvm::BasicBlock *, llvm::ConstantInt *>,
+                 std::pair<llvm::Value *, uint32_t>>
+      Shared;
 };
 
 // See https://obfuscator.re/omvll/passes/opaque-constants for details.
 struct OpaqueConstants : llvm::PassInfoMixin<OpaqueConstants> {
   llvm::PreservedAnalyses run(llvm::Module &M,
                               llvm::ModuleAnalysisManager &FAM);
-  bool runOnBasicBlock(llvm::BasicBlock &BB, OpaqueConstantsOpt *Opt);
 
-  bool process(llvm::Instruction &I, OpaqueConstantsOpt *Opt);
+  // Steps of run(), see FunctionPassGroup.
+  bool beginModule(llvm::Module &) { return false; }
+  bool visitFunction(llvm::Function &F);
+  bool endModule(llvm::Module &) { return false; }
+  // Calls the callbacks of UserConfig visitFunction() would call on F.
+  static void queryConfig(ObfuscationConfig &UserConfig, llvm::Function &F);
+
+  // The opaque expressions are inserted before InsertPt if set, before the
+  // instruction using the constant otherwise.
+  bool runOnBasicBlock(llvm::BasicBlock &BB, OpaqueConstantsOpt *Opt,
+                       llvm::Instruction *InsertPt = nullptr);
+
+  bool process(llvm::Instruction &I, OpaqueConstantsOpt *Opt,
+               llvm::Instruction *InsertPt = nullptr);
   bool process(llvm::Instruction &I, llvm::Use &Op, llvm::ConstantInt &CI,
-               OpaqueConstantsOpt *Opt);
+               OpaqueConstantsOpt *Opt, llvm::Instruction *InsertPt = nullptr);
 
   OpaqueContext *getOrCreateContext(llvm::Function &F);
 
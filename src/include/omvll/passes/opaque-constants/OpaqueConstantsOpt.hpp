@@ -15,42 +15,80 @@ namespace omvll {
 
 struct OpaqueConstantsSkip {};
 
-struct OpaqueConstantsBool  {
-  OpaqueConstantsBool(bool Value, uint8_t ArithRounds = 0)
-      : Value(Value), ArithRounds(ArithRounds) {}
+// Settings shared by all the options enabling the protection.
+struct OpaqueConstantsTuning {
+  OpaqueConstantsTuning(uint8_t ArithRounds, bool RegisterSeeds,
+                        uint32_t LatencyBudget, uint32_t ReuseFactor,
+                        bool HoistFromLoops)
+      : ArithRounds(ArithRounds), RegisterSeeds(RegisterSeeds),
+        LatencyBudget(LatencyBudget), ReuseFactor(ReuseFactor),
+        HoistFromLoops(HoistFromLoops) {}
+  uint8_t ArithRounds = 0;
+  bool RegisterSeeds = false;
+  // Estimated cycles the opaque expressions may add to a function, 0 meaning
+  // no budget.
+  uint32_t LatencyBudget = 0;
+  // Number of uses of a constant within a basic block that share the same
+  // opaque expression (0 and 1 meaning no sharing).
+  uint32_t ReuseFactor = 0;
+  // Compute the opaque constants of loops in the preheader of the outermost
+  // loop rather than at every iteration.
+  bool HoistFromLoops = true;
+};
+
+struct OpaqueConstantsBool : OpaqueConstantsTuning {
+  OpaqueConstantsBool(bool Value, uint8_t ArithRounds = 0,
+                      bool RegisterSeeds = false,
+                      uint32_t LatencyBudget = 0, uint32_t ReuseFactor = 0,
+                      bool HoistFromLoops = true)
+      : OpaqueConstantsTuning(ArithRounds, RegisterSeeds, LatencyBudget,
+                              ReuseFactor, HoistFromLoops),
+        Value(Value) {}
   operator bool() const { return Value; }
   bool Value = false;
-  uint8_t ArithRounds = 0;
 };
 
-struct OpaqueConstantsLowerLimit {
-  OpaqueConstantsLowerLimit(uint64_t Value, uint8_t ArithRounds = 0)
-      : Value(Value), ArithRounds(ArithRounds) {}
+struct OpaqueConstantsLowerLimit : OpaqueConstantsTuning {
+  OpaqueConstantsLowerLimit(uint64_t Value, uint8_t ArithRounds = 0,
+                            bool RegisterSeeds = false,
+                            uint32_t LatencyBudget = 0,
+                            uint32_t ReuseFactor = 0, bool HoistFromLoops = true)
+      : OpaqueConstantsTuning(ArithRounds, RegisterSeeds, LatencyBudget,
+                              ReuseFactor, HoistFromLoops),
+        Value(Value) {}
   operator bool() const { return Value > 0; }
   uint64_t Value = 0;
-  uint8_t ArithRounds = 0;
 };
 
-struct OpaqueConstantsSet {
-  OpaqueConstantsSet(std::vector<uint64_t> Value, uint8_t ArithRounds = 0)
-      : Values(Value.begin(), Value.end()), ArithRounds(ArithRounds) {}
+struct OpaqueConstantsSet : OpaqueConstantsTuning {
+  OpaqueConstantsSet(std::vector<uint64_t> Value, uint8_t ArithRounds = 0,
+                     bool RegisterSeeds = false,
+                     uint32_t LatencyBudget = 0, uint32_t ReuseFactor = 0,
+                     bool HoistFromLoops = true)
+      : OpaqueConstantsTuning(ArithRounds, RegisterSeeds, LatencyBudget,
+                              ReuseFactor, HoistFromLoops),
+        Values(Value.begin(), Value.end()) {}
 
   inline bool contains(uint64_t Value) const { return Values.contains(Value); }
   inline bool empty() { return Values.empty(); };
   inline operator bool() const { return !Values.empty(); }
   llvm::DenseSet<uint64_t> Values;
-  uint8_t ArithRounds = 0;
 };
 
-struct OpaqueConstantsExcludeSet {
-  OpaqueConstantsExcludeSet(std::vector<uint64_t> Value, uint8_t ArithRounds = 0)
-      : Values(Value.begin(), Value.end()), ArithRounds(ArithRounds) {}
+struct OpaqueConstantsExcludeSet : OpaqueConstantsTuning {
+  OpaqueConstantsExcludeSet(std::vector<uint64_t> Value,
+                            uint8_t ArithRounds = 0,
+                            bool RegisterSeeds = false,
+                            uint32_t LatencyBudget = 0,
+                            uint32_t ReuseFactor = 0, bool HoistFromLoops = true)
+      : OpaqueConstantsTuning(ArithRounds, RegisterSeeds, LatencyBudget,
+                              ReuseFactor, HoistFromLoops),
+        Values(Value.begin(), Value.end()) {}
 
   inline bool contains(uint64_t Value) const { return Values.contains(Value); }
   inline bool empty() { return Values.empty(); };
   inline operator bool() const { return !Values.empty(); }
   llvm::DenseSet<uint64_t> Values;
-  uint8_t ArithRounds = 0;
 };
 
 using OpaqueConstantsOpt = std::variant<
@@ -5,6 +5,8 @@
 // details.
 //
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/PassManager.h"
 
 // Forward declarations
@@ -16,6 +18,8 @@ class LoadInst;
 class StoreInst;
 class ConstantInt;
 class ConstantExpr;
+class DataLayout;
+class Function;
 } // end namespace llvm
 
 namespace omvll {
@@ -49,6 +53,18 @@ struct OpaqueFieldAccess : llvm::PassInfoMixin<OpaqueFieldAccess> {
 
   bool runOnConstantExprWrite(llvm::BasicBlock &BB, llvm::StoreInst &Store,
                               llvm::ConstantExpr &CE);
+
+private:
+  bool shouldObfuscateStruct(llvm::Function &F, llvm::StructType &S);
+  uint64_t getFieldOffset(const llvm::DataLayout &DL, llvm::StructType &S,
+                          uint64_t Idx);
+
+  // Caches reset for each module: the user's decision for the accesses to a
+  // structure from a function, and the offsets of the structure fields.
+  llvm::DenseMap<std::pair<llvm::Function *, llvm::StructType *>, bool>
+      StructDecisions;
+  llvm::DenseMap<llvm::StructType *, llvm::SmallVector<uint64_t, 8>>
+      FieldOffsets;
 };
 
 } // end namespace omvll
@@ -8,6 +8,7 @@
 #include <random>
 #include <string>
 
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/LLVMContext.h"
@@ -62,6 +63,8 @@ bool isFunctionGloballyExcluded(llvm::Function *F);
 bool isCoroutine(llvm::Function *F);
 bool containsSwiftErrorAlloca(const llvm::BasicBlock &BB);
 bool isEHBlock(const llvm::BasicBlock &BB);
+llvm::SmallPtrSet<const llvm::BasicBlock *, 16>
+findHotBlocks(llvm::Function &F);
 void inlineWithoutLifetimeMarkers(llvm::CallInst *Call);
 
 [[noreturn]] void fatalError(std::string_view Msg);
@@ -105,12 +108,31 @@ class RandomGenerator {
 private:
   static bool Seeded;
   static std::mt19937_64 MtEngine;
+  // Stream of the function being transformed on this thread, if any.
+  static thread_local std::mt19937_64 *FunctionEngine;
+
+  static std::mt19937_64 &getEngine();
 
 public:
   static uint64_t generateFullRand();
   static uint64_t generateRange(uint64_t a, uint64_t b);
   static int generate();
   static int checkProbability(int Target);
+
+  // With Config.PerFunctionSeeds, the numbers drawn on this thread while the
+  // stream is alive only depend on the seed and the function name, hence not
+  // on the order in which the functions are transformed. No-op otherwise.
+  class FunctionStream {
+  public:
+    FunctionStream(const llvm::Function &F);
+    ~FunctionStream();
+    FunctionStream(const FunctionStream &) = delete;
+    FunctionStream &operator=(const FunctionStream &) = delete;
+
+  private:
+    std::mt19937_64 Engine;
+    std::mt19937_64 *Previous;
+  };
 };
 
 } // end namespace omvll
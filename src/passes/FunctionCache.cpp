@@ -0,0 +1,279 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
+#include "omvll/PyConfig.hpp"
+#include "omvll/log.hpp"
+#include "omvll/omvll_config.hpp"
+#include "omvll/passes/FunctionCache.hpp"
+#include "omvll/passes/FunctionTransfer.hpp"
+#include "omvll/versioning.hpp"
+
+using namespace llvm;
+
+namespace omvll {
+
+static constexpr auto CacheDirName = "functions";
+
+namespace {
+
+// Prints the metadata a function refers to by content: the printed IR only
+// refers to the nodes by their slot number.
+class MetadataPrinter {
+public:
+  MetadataPrinter(raw_ostream &OS, ModuleSlotTracker &MST) : OS(OS), MST(MST) {}
+
+  // Returns false on nodes that are not tuples (e.g., debug info), whose
+  // fields are not all operands.
+  bool print(const Metadata *MD) {
+    if (!MD) {
+      OS << "null";
+      return true;
+    }
+
+    if (auto *S = dyn_cast<MDString>(MD)) {
+      OS << '"';
+      printEscapedString(S->getString(), OS);
+      OS << '"';
+      return true;
+    }
+
+    if (auto *VAM = dyn_cast<ValueAsMetadata>(MD)) {
+      VAM->getValue()->printAsOperand(OS, /* PrintType */ true, MST);
+      return true;
+    }
+
+    auto *N = dyn_cast<MDTuple>(MD);
+    if (!N)
+      return false;
+
+    auto [It, Inserted] = Ids.try_emplace(N, Ids.size());
+    OS << '!' << It->second;
+    if (!Inserted)
+      return true;
+
+    OS << (N->isDistinct() ? " = distinct !{" : " = !{");
+    for (const MDOperand &Op : N->operands()) {
+      if (!print(Op.get()))
+        return false;
+      OS << ", ";
+    }
+    OS << '}';
+    return true;
+  }
+
+private:
+  raw_ostream &OS;
+  ModuleSlotTracker &MST;
+  DenseMap<const MDNode *, unsigned> Ids;
+};
+
+static void printAttributes(raw_ostream &OS, AttributeList Attrs) {
+  for (unsigned Index : Attrs.indexes())
+    OS << Index << ": " << Attrs.getAsString(Index) << '\n';
+}
+
+} // end anonymous namespace
+
+FunctionCache::FunctionCache(Module &M, StringRef PassesID)
+    : M(M), MST(&M) {
+  SmallString<256> Path(Config.OutputFolder);
+  sys::path::append(Path, "cache", CacheDirName);
+  if (std::error_code EC = sys::fs::create_directories(Path))
+    SWARN("Cannot create the function cache {}: {}", Path.str(),
+          EC.message());
+  Dir = Path.str().str();
+
+  for (const GlobalValue &GV : M.global_values())
+    Existing.insert(&GV);
+
+  // The user configuration is a Python module: its content is hashed, but not
+  // the content of the modules it imports.
+  uint64_t PyConfigHash = 0;
+  if (auto Buffer = MemoryBuffer::getFile(PyConfig::instance().configPath()))
+    PyConfigHash = xxh3_64bits(arrayRefFromStringRef((*Buffer)->getBuffer()));
+
+  raw_string_ostream OS(Prefix);
+  OS << OMVLL_VERSION << '\n'
+     << OMVLL_LLVM_VERSION_STRING << '\n'
+     << PyConfigHash << '\n'
+     << Config.ProbabilitySeed << ',' << Config.SkipObfuscatedFunctions
+     << '\n'
+     << PassesID << '\n'
+     << M.getModuleIdentifier() << '\n'
+     << M.getSourceFileName() << '\n'
+     << M.getTargetTriple() << '\n'
+     << M.getDataLayoutStr() << '\n';
+}
+
+bool FunctionCache::isEnabled() {
+  if (!Config.IncrementalCache)
+    return false;
+
+  // Without per-function seeds, the obfuscation of a function depends on the
+  // functions processed before it and cannot be reused.
+  if (Config.OutputFolder.empty() || !Config.PerFunctionSeeds) {
+    SWARN("incremental_cache requires output_folder and per_function_seeds");
+    return false;
+  }
+  return true;
+}
+
+std::string FunctionCache::getEntryPath(uint64_t Key) const {
+  SmallString<256> Path(Dir);
+  sys::path::append(Path, utohexstr(Key, /* LowerCase */ true) + ".bc");
+  return Path.str().str();
+}
+
+std::optional<uint64_t> FunctionCache::getKey(Function &F) {
+  if (F.isDeclaration() || !F.hasName() || F.getSubprogram() ||
+      any_of(F, [](const BasicBlock &BB) { return BB.hasAddressTaken(); }))
+    return std::nullopt;
+
+  FunctionRefs Refs;
+  Refs.addFunction(F);
+  if (any_of(Refs.Globals, [](GlobalValue *GV) { return !GV->hasName(); }))
+    return std::nullopt;
+
+  std::string Text = Prefix;
+  raw_string_ostream OS(Text);
+  for (StructType *ST : Refs.Structs) {
+    ST->print(OS);
+    OS << '\n';
+  }
+  for (GlobalValue *GV : Refs.Globals) {
+    OS << GV->getName() << ' ' << GV->getLinkage() << ' ';
+    GV->getValueType()->print(OS);
+    OS << '\n';
+  }
+  static_cast<const Value &>(F).print(OS, MST);
+
+  // The printed IR refers to the attribute groups and metadata by number:
+  // append their content.
+  MST.incorporateFunction(F);
+  MetadataPrinter MDPrinter(OS, MST);
+  // Custom kind IDs depend on the order they were registered in.
+  SmallVector<StringRef, 32> KindNames;
+  F.getContext().getMDKindNames(KindNames);
+  auto PrintAttachments = [&](ArrayRef<std::pair<unsigned, MDNode *>> MDs) {
+    for (auto [Kind, MD] : MDs) {
+      OS << '!' << KindNames[Kind] << ' ';
+      if (!MDPrinter.print(MD))
+        return false;
+      OS << '\n';
+    }
+    return true;
+  };
+
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  printAttributes(OS, F.getAttributes());
+  F.getAllMetadata(MDs);
+  if (!PrintAttachments(MDs))
+    return std::nullopt;
+
+  for (Instruction &I : instructions(F)) {
+    if (auto *CB = dyn_cast<CallBase>(&I))
+      printAttributes(OS, CB->getAttributes());
+    for (Value *Op : I.operands())
+      if (auto *MAV = dyn_cast<MetadataAsValue>(Op))
+        if (!MDPrinter.print(MAV->getMetadata()))
+          return std::nullopt;
+
+    MDs.clear();
+    I.getAllMetadata(MDs);
+    if (!PrintAttachments(MDs))
+      return std::nullopt;
+  }
+
+  return xxh3_64bits(arrayRefFromStringRef(OS.str()));
+}
+
+bool FunctionCache::load(uint64_t Key, Function &F) {
+  auto Buffer = MemoryBuffer::getFile(getEntryPath(Key));
+  if (!Buffer)
+    return false;
+
+  LLVMContext &Ctx = M.getContext();
+  Expected<std::unique_ptr<Module>> EntryOrErr =
+      parseBitcodeFile((*Buffer)->getMemBufferRef(), Ctx);
+  if (!EntryOrErr) {
+    SWARN("Cannot read the cache entry of {}: {}", F.getName(),
+          toString(EntryOrErr.takeError()));
+    return false;
+  }
+
+  Module &Entry = **EntryOrErr;
+  FunctionSplicer Splicer(M, Entry);
+  if (!Splicer.splice(F))
+    return false;
+
+  SINFO("[FunctionCache] Reusing the cached obfuscation of {}", F.getName());
+  return true;
+}
+
+void FunctionCache::store(uint64_t Key, Function &F) {
+  FunctionRefs Refs;
+  Refs.addFunction(F);
+  for (GlobalValue *GV : Refs.Globals) {
+    if (GV == &F)
+      continue;
+
+    // E.g., the tables of IndirectCall and IndirectBranch, which are created
+    // in beginModule() or while visiting the functions.
+    auto *Fn = dyn_cast<Function>(GV);
+    if (!GV->hasName() || !(Fn || isa<GlobalVariable>(GV)) ||
+        !(Existing.contains(GV) || (Fn && Fn->isIntrinsic()))) {
+      SDEBUG("[FunctionCache] Not caching {}: it refers to {}, created by the "
+             "passes",
+             F.getName(), GV->getName());
+      return;
+    }
+  }
+
+  std::unique_ptr<Module> Entry = extractFunctions({&F}, F.getName());
+
+  // Parallel builds may store the same entry: write it to a temporary file
+  // first, then move it into place.
+  std::string Path = getEntryPath(Key);
+  SmallString<256> TmpPath;
+  int FD = -1;
+  if (std::error_code EC =
+          sys::fs::createUniqueFile(Path + ".%%%%%%.tmp", FD, TmpPath)) {
+    SWARN("Cannot store {} in the function cache: {}", F.getName(),
+          EC.message());
+    return;
+  }
+
+  {
+    raw_fd_ostream OS(FD, /* shouldClose */ true);
+    WriteBitcodeToFile(*Entry, OS);
+  }
+
+  if (std::error_code EC = sys::fs::rename(TmpPath, Path)) {
+    SWARN("Cannot store {} in the function cache: {}", F.getName(),
+          EC.message());
+    sys::fs::remove(TmpPath);
+  }
+}
+
+} // end namespace omvll
@@ -0,0 +1,431 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include <algorithm>
+#include <optional>
+
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Bitcode/BitcodeReader.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "omvll/passes/FunctionPassGroup.hpp"
+#include "omvll/passes/FunctionCache.hpp"
+#include "omvll/passes/FunctionTransfer.hpp"
+#include "omvll/ObfuscationConfig.hpp"
+#include "omvll/PyConfig.hpp"
+#include "omvll/log.hpp"
+#include "omvll/omvll_config.hpp"
+#include "omvll/utils.hpp"
+
+using namespace llvm;
+
+namespace omvll {
+
+namespace {
+
+// User configuration of the worker threads, which must not call into Python:
+// the answers of the callbacks are recorded beforehand, on the current thread,
+// then replayed once frozen.
+class RecordedConfig : public ObfuscationConfig {
+public:
+  RecordedConfig(ObfuscationConfig &UserConfig) : UserConfig(UserConfig) {}
+
+  void freeze() { Frozen = true; }
+
+  OpaqueConstantsOpt obfuscateConstants(Module *M, Function *F) override {
+    return record(Constants, F,
+                  [&] { return UserConfig.obfuscateConstants(M, F); });
+  }
+
+  ArithmeticOpt obfuscateArithmetics(Module *M, Function *F) override {
+    return record(Arithmetics, F,
+                  [&] { return UserConfig.obfuscateArithmetics(M, F); });
+  }
+
+  // The other callbacks are not recorded.
+  StringEncodingOpt obfuscateString(Module *M, Function *F,
+                                    const std::string &Str) override {
+    checkNotFrozen("obfuscateString");
+    return UserConfig.obfuscateString(M, F, Str);
+  }
+
+  StructAccessOpt obfuscateStructAccess(Module *M, Function *F,
+                                        StructType *S) override {
+    checkNotFrozen("obfuscateStructAccess");
+    return UserConfig.obfuscateStructAccess(M, F, S);
+  }
+
+  VarAccessOpt obfuscateVariableAccess(Module *M, Function *F,
+                                       GlobalVariable *S) override {
+    checkNotFrozen("obfuscateVariableAccess");
+    return UserConfig.obfuscateVariableAccess(M, F, S);
+  }
+
+  BreakControlFlowOpt breakControlFlow(Module *M, Function *F) override {
+    checkNotFrozen("breakControlFlow");
+    return UserConfig.breakControlFlow(M, F);
+  }
+
+  ControlFlowFlatteningOpt controlFlowGraphFlattening(Module *M,
+                                                      Function *F) override {
+    checkNotFrozen("controlFlowGraphFlattening");
+    return UserConfig.controlFlowGraphFlattening(M, F);
+  }
+
+  AntiHookOpt antiHooking(Module *M, Function *F) override {
+    checkNotFrozen("antiHooking");
+    return UserConfig.antiHooking(M, F);
+  }
+
+  IndirectBranchOpt indirectBranch(Module *M, Function *F) override {
+    checkNotFrozen("indirectBranch");
+    return UserConfig.indirectBranch(M, F);
+  }
+
+  IndirectCallOpt indirectCall(Module *M, Function *F) override {
+    checkNotFrozen("indirectCall");
+    return UserConfig.indirectCall(M, F);
+  }
+
+  BasicBlockDuplicateOpt basicBlockDuplicate(Module *M, Function *F) override {
+    checkNotFrozen("basicBlockDuplicate");
+    return UserConfig.basicBlockDuplicate(M, F);
+  }
+
+  FunctionOutlineOpt functionOutline(Module *M, Function *F) override {
+    checkNotFrozen("functionOutline");
+    return UserConfig.functionOutline(M, F);
+  }
+
+  bool defaultConfig(Module *M, Function *F,
+                     const std::vector<std::string> &ModuleExcludes,
+                     const std::vector<std::string> &FunctionExcludes,
+                     const std::vector<std::string> &FunctionIncludes,
+                     int Probability) override {
+    checkNotFrozen("defaultConfig");
+    return UserConfig.defaultConfig(M, F, ModuleExcludes, FunctionExcludes,
+                                    FunctionIncludes, Probability);
+  }
+
+  bool hasReportDiffOverride() override {
+    checkNotFrozen("hasReportDiffOverride");
+    return UserConfig.hasReportDiffOverride();
+  }
+
+  void reportDiff(const std::string &Pass, const std::string &Original,
+                  const std::string &Obfuscated) override {
+    checkNotFrozen("reportDiff");
+    UserConfig.reportDiff(Pass, Original, Obfuscated);
+  }
+
+private:
+  template <typename OptT, typename QueryT>
+  OptT record(StringMap<OptT> &Answers, Function *F, QueryT Query) {
+    if (!Frozen)
+      return Answers[F->getName()] = Query();
+
+    auto It = Answers.find(F->getName());
+    if (It == Answers.end())
+      fatalError("No recorded configuration for " + F->getName().str());
+    return It->second;
+  }
+
+  void checkNotFrozen(StringRef Callback) {
+    if (Frozen)
+      fatalError(Callback.str() + " cannot be called on a worker thread");
+  }
+
+  ObfuscationConfig &UserConfig;
+  bool Frozen = false;
+  StringMap<OpaqueConstantsOpt> Constants;
+  StringMap<ArithmeticOpt> Arithmetics;
+};
+
+// Functions obfuscated on a worker thread.
+struct Shard {
+  std::vector<Function *> Functions;
+  std::vector<std::string> Names;
+  // Bitcode of the functions, then of the functions once obfuscated.
+  SmallVector<char, 0> Bitcode;
+  // Whether the passes changed each of the functions.
+  std::vector<bool> Changed;
+  bool Failed = false;
+};
+
+#if LLVM_VERSION_MAJOR > 18
+using WorkerPool = DefaultThreadPool;
+#else
+using WorkerPool = ThreadPool;
+#endif
+
+// Worker threads, created on first use and shared by the following runs (e.g.,
+// the other phase or the other groups of the pipeline).
+WorkerPool &getWorkerPool() {
+  static WorkerPool Pool(hardware_concurrency(Config.FunctionPassThreads));
+  return Pool;
+}
+
+} // end anonymous namespace
+
+bool FunctionPassGroup::runInParallel(Module &M, ArrayRef<Function *> Fns,
+                                      size_t NumPasses) {
+  ArrayRef<std::unique_ptr<Concept>> Parallel =
+      ArrayRef<std::unique_ptr<Concept>>(Passes).take_front(NumPasses);
+
+  // The functions that cannot be copied are obfuscated on this thread.
+  std::vector<Function *> Local;
+  std::vector<Function *> Extractable;
+  for (Function *F : Fns) {
+    if (F->isDeclaration())
+      continue;
+    (isExtractable(*F) ? Extractable : Local).push_back(F);
+  }
+
+  RecordedConfig Answers(*PyConfig::instance().getUserConfig());
+  for (Function *F : Extractable)
+    for (const std::unique_ptr<Concept> &Pass : Parallel)
+      Pass->queryConfig(Answers, *F);
+  Answers.freeze();
+
+  // Contiguous shards of about the same number of instructions.
+  size_t NumShards =
+      std::min<size_t>(Config.FunctionPassThreads, Extractable.size());
+  std::vector<Shard> Shards(NumShards);
+  size_t Total = 0;
+  for (Function *F : Extractable)
+    Total += F->getInstructionCount();
+
+  size_t Size = 0;
+  for (Function *F : Extractable) {
+    size_t Idx = std::min(NumShards - 1, Size * NumShards / (Total + 1));
+    Shards[Idx].Functions.push_back(F);
+    Shards[Idx].Names.push_back(F->getName().str());
+    Size += F->getInstructionCount();
+  }
+
+  for (Shard &S : Shards) {
+    if (S.Functions.empty())
+      continue;
+    std::unique_ptr<Module> Copy = extractFunctions(S.Functions, M.getName());
+    raw_svector_ostream OS(S.Bitcode);
+    WriteBitcodeToFile(*Copy, OS);
+  }
+
+  SINFO("[{}] Running {} passes over {} functions on {} threads", name(),
+        Parallel.size(), Extractable.size(), NumShards);
+
+  std::shared_ptr<spdlog::logger> Log = Logger::CurrentOrDefault();
+  std::string ModuleName = M.getName().str();
+  auto RunShard = [&](Shard &S) {
+    // The pool threads outlive the module: leave them without its sink.
+    Logger::BindLogger(Log);
+    auto Unbind = make_scope_exit([] { Logger::BindLogger(nullptr); });
+    PyConfig::ThreadOverride Override(&Answers);
+
+    LLVMContext Ctx;
+    Expected<std::unique_ptr<Module>> CopyOrErr = parseBitcodeFile(
+        MemoryBufferRef(StringRef(S.Bitcode.data(), S.Bitcode.size()),
+                        ModuleName),
+        Ctx);
+    if (!CopyOrErr) {
+      SWARN("[{}] Cannot read a shard of {}: {}", name(), ModuleName,
+            toString(CopyOrErr.takeError()));
+      S.Failed = true;
+      return;
+    }
+
+    Module &Copy = **CopyOrErr;
+    S.Bitcode.clear();
+
+    std::vector<std::unique_ptr<Concept>> ShardPasses;
+    for (const std::unique_ptr<Concept> &Pass : Parallel)
+      ShardPasses.push_back(Pass->create());
+
+    bool ModuleChanged = false;
+    for (std::unique_ptr<Concept> &Pass : ShardPasses)
+      ModuleChanged |= Pass->beginModule(Copy);
+
+    S.Changed.assign(S.Names.size(), false);
+    for (size_t Idx = 0; Idx < S.Names.size(); ++Idx) {
+      Function &F = *Copy.getFunction(S.Names[Idx]);
+      bool Changed = false;
+      for (std::unique_ptr<Concept> &Pass : ShardPasses)
+        Changed |= Pass->visitFunction(F);
+      S.Changed[Idx] = Changed;
+    }
+
+    for (std::unique_ptr<Concept> &Pass : ShardPasses)
+      ModuleChanged |= Pass->endModule(Copy);
+
+    // The changes of beginModule() and endModule() are not tied to a function.
+    if (ModuleChanged)
+      S.Changed.assign(S.Names.size(), true);
+
+    raw_svector_ostream OS(S.Bitcode);
+    WriteBitcodeToFile(Copy, OS);
+  };
+
+  ThreadPoolTaskGroup Tasks(getWorkerPool());
+  for (Shard &S : Shards)
+    if (!S.Functions.empty())
+      Tasks.async(RunShard, std::ref(S));
+  Tasks.wait();
+
+  // The functions of a shard that cannot be spliced back are obfuscated again
+  // on this thread.
+  bool Changed = false;
+  for (Shard &S : Shards) {
+    if (S.Functions.empty())
+      continue;
+
+    std::unique_ptr<Module> Copy;
+    if (!S.Failed) {
+      Expected<std::unique_ptr<Module>> CopyOrErr = parseBitcodeFile(
+          MemoryBufferRef(StringRef(S.Bitcode.data(), S.Bitcode.size()),
+                          ModuleName),
+          M.getContext());
+      if (CopyOrErr)
+        Copy = std::move(*CopyOrErr);
+      else
+        SWARN("[{}] Cannot read a shard of {}: {}", name(), ModuleName,
+              toString(CopyOrErr.takeError()));
+      S.Bitcode = {};
+    }
+
+    std::optional<FunctionSplicer> Splicer;
+    if (Copy)
+      Splicer.emplace(M, *Copy);
+    bool CanSplice = Splicer && Splicer->isValid();
+
+    for (size_t Idx = 0; Idx < S.Functions.size(); ++Idx) {
+      Function *F = S.Functions[Idx];
+      if (CanSplice && !S.Changed[Idx])
+        continue;
+      if (CanSplice && Splicer->splice(*F)) {
+        Changed = true;
+        continue;
+      }
+      Local.push_back(F);
+    }
+  }
+
+  if (Local.empty())
+    return Changed;
+
+  for (const std::unique_ptr<Concept> &Pass : Parallel)
+    Changed |= Pass->beginModule(M);
+  for (Function *F : Local)
+    for (const std::unique_ptr<Concept> &Pass : Parallel)
+      Changed |= Pass->visitFunction(*F);
+  for (const std::unique_ptr<Concept> &Pass : Parallel)
+    Changed |= Pass->endModule(M);
+  return Changed;
+}
+
+PreservedAnalyses FunctionPassGroup::run(Module &M,
+                                         ModuleAnalysisManager &MAM) {
+  // report_diff compares the IR before and after each pass: the passes must
+  // then run one after the other.
+  ObfuscationConfig *UserConfig = PyConfig::instance().getUserConfig();
+  bool ReportDiff = UserConfig->hasReportDiffOverride();
+  bool UseCache = !ReportDiff && FunctionCache::isEnabled();
+  bool Fuse = Config.FuseFunctionPasses && Passes.size() >= 2;
+
+  // Without per-function seeds, the output would depend on the shards.
+  size_t NumParallel = 0;
+  if (!ReportDiff && Config.FunctionPassThreads > 1) {
+    if (!Config.PerFunctionSeeds)
+      SWARN("function_pass_threads requires per_function_seeds");
+    else
+      while (NumParallel < Passes.size() &&
+             Passes[NumParallel]->canRunInParallel())
+        ++NumParallel;
+  }
+
+  if (ReportDiff || (!Fuse && !UseCache && !NumParallel)) {
+    PreservedAnalyses PA = PreservedAnalyses::all();
+    for (std::unique_ptr<Concept> &Pass : Passes) {
+      PreservedAnalyses PassPA = Pass->run(M, MAM);
+      MAM.invalidate(M, PassPA);
+      PA.intersect(std::move(PassPA));
+    }
+    return PA;
+  }
+
+  if (isModuleGloballyExcluded(&M)) {
+    SINFO("Excluding module [{}]", M.getName());
+    return PreservedAnalyses::all();
+  }
+
+  SINFO("[{}] Executing {} passes on module {}", name(), Passes.size(),
+        M.getName());
+
+  std::optional<FunctionCache> Cache;
+  if (UseCache) {
+    std::string PassesID;
+    for (std::unique_ptr<Concept> &Pass : Passes)
+      PassesID += Pass->name().str() + ";";
+    Cache.emplace(M, PassesID);
+  }
+
+  // Backup all the functions since the passes may add new functions.
+  std::vector<Function *> ToVisit;
+  ToVisit.reserve(M.size());
+  for (Function &F : M)
+    ToVisit.push_back(&F);
+
+  // The functions found in the cache skip the passes. The others are stored
+  // once the passes are done with the module, since endModule() may still
+  // change them.
+  bool Changed = false;
+  std::vector<Function *> Misses;
+  SmallVector<std::pair<Function *, uint64_t>, 32> ToStore;
+  for (Function *F : ToVisit) {
+    std::optional<uint64_t> Key = Cache ? Cache->getKey(*F) : std::nullopt;
+    if (Key && Cache->load(*Key, *F)) {
+      Changed = true;
+      continue;
+    }
+
+    Misses.push_back(F);
+    if (Key)
+      ToStore.push_back({F, *Key});
+  }
+
+  // The leading passes that only change the function they visit run on
+  // worker threads; the others then run in a single walk.
+  if (NumParallel)
+    Changed |= runInParallel(M, Misses, NumParallel);
+
+  ArrayRef<std::unique_ptr<Concept>> Walked =
+      ArrayRef<std::unique_ptr<Concept>>(Passes).drop_front(NumParallel);
+  for (const std::unique_ptr<Concept> &Pass : Walked)
+    Changed |= Pass->beginModule(M);
+
+  for (Function *F : Misses)
+    for (const std::unique_ptr<Concept> &Pass : Walked)
+      Changed |= Pass->visitFunction(*F);
+
+  for (const std::unique_ptr<Concept> &Pass : Walked)
+    Changed |= Pass->endModule(M);
+
+  for (auto [F, Key] : ToStore)
+    Cache->store(Key, *F);
+
+  SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
+        M.getName());
+
+  return Changed ? PreservedAnalyses::none() : PreservedAnalyses::all();
+}
+
+} // end namespace omvll
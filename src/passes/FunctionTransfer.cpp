@@ -0,0 +1,234 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Operator.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "omvll/passes/FunctionTransfer.hpp"
+
+using namespace llvm;
+
+namespace omvll {
+
+// Names of the struct types of an extracted module, which the bitcode reader
+// renames when they are already used in the context.
+static constexpr auto TypesMDName = "omvll.cache.types";
+
+void FunctionRefs::addType(Type *Ty) {
+  if (auto *ST = dyn_cast<StructType>(Ty))
+    if (!ST->isLiteral() && !Structs.insert(ST))
+      return;
+  for (Type *Sub : Ty->subtypes())
+    addType(Sub);
+}
+
+void FunctionRefs::addValue(Value *V) {
+  auto *C = dyn_cast<Constant>(V);
+  if (!C || !Visited.insert(C).second)
+    return;
+
+  addType(C->getType());
+  if (auto *GV = dyn_cast<GlobalValue>(C)) {
+    Globals.insert(GV);
+    addType(GV->getValueType());
+    return;
+  }
+
+  if (auto *GEP = dyn_cast<GEPOperator>(C))
+    addType(GEP->getSourceElementType());
+  for (Value *Op : C->operands())
+    addValue(Op);
+}
+
+void FunctionRefs::addFunction(Function &F) {
+  addValue(&F);
+  if (F.hasPersonalityFn())
+    addValue(F.getPersonalityFn());
+
+  for (Instruction &I : instructions(F)) {
+    addType(I.getType());
+    for (Value *Op : I.operands()) {
+      addType(Op->getType());
+      addValue(Op);
+    }
+
+    if (auto *AI = dyn_cast<AllocaInst>(&I))
+      addType(AI->getAllocatedType());
+    else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I))
+      addType(GEP->getSourceElementType());
+    else if (auto *CB = dyn_cast<CallBase>(&I))
+      addType(CB->getFunctionType());
+  }
+}
+
+bool isExtractable(Function &F) {
+  if (F.isDeclaration() || !F.hasName() || F.getSubprogram() ||
+      any_of(F, [](const BasicBlock &BB) { return BB.hasAddressTaken(); }))
+    return false;
+
+  FunctionRefs Refs;
+  Refs.addFunction(F);
+  return all_of(Refs.Globals, [](GlobalValue *GV) {
+    return GV->hasName() && (isa<Function>(GV) || isa<GlobalVariable>(GV));
+  }) && all_of(Refs.Structs, [](StructType *ST) { return ST->hasName(); });
+}
+
+std::unique_ptr<Module> extractFunctions(ArrayRef<Function *> Fns,
+                                         StringRef Name) {
+  assert(!Fns.empty() && "Nothing to extract");
+  Module &M = *Fns.front()->getParent();
+  LLVMContext &Ctx = M.getContext();
+  auto Entry = std::make_unique<Module>(Name, Ctx);
+  Entry->setDataLayout(M.getDataLayout());
+  Entry->setTargetTriple(M.getTargetTriple());
+
+  // The entry holds Fns along with declarations of the globals they refer to.
+  FunctionRefs Refs;
+  ValueToValueMapTy VMap;
+  for (Function *F : Fns) {
+    Refs.addFunction(*F);
+    VMap[F] = Function::Create(F->getFunctionType(),
+                               GlobalValue::ExternalLinkage, F->getName(),
+                               *Entry);
+  }
+
+  for (GlobalValue *GV : Refs.Globals) {
+    if (VMap.count(GV))
+      continue;
+
+    if (auto *Fn = dyn_cast<Function>(GV)) {
+      Function *Decl =
+          Function::Create(Fn->getFunctionType(), GlobalValue::ExternalLinkage,
+                           Fn->getName(), *Entry);
+      Decl->copyAttributesFrom(Fn);
+      VMap[GV] = Decl;
+      continue;
+    }
+
+    auto *GVar = cast<GlobalVariable>(GV);
+    VMap[GV] = new GlobalVariable(
+        *Entry, GVar->getValueType(), GVar->isConstant(),
+        GlobalValue::ExternalLinkage, /* Initializer */ nullptr,
+        GVar->getName(), /* InsertBefore */ nullptr,
+        GVar->getThreadLocalMode(), GVar->getAddressSpace());
+  }
+
+  for (Function *F : Fns) {
+    auto *NewF = cast<Function>(VMap[F]);
+    for (auto [Arg, NewArg] : zip(F->args(), NewF->args()))
+      VMap[&Arg] = &NewArg;
+
+    SmallVector<ReturnInst *, 8> Returns;
+    CloneFunctionInto(NewF, F, VMap, CloneFunctionChangeType::DifferentModule,
+                      Returns);
+  }
+
+  NamedMDNode *Names = Entry->getOrInsertNamedMetadata(TypesMDName);
+  for (StructType *ST : Refs.Structs)
+    Names->addOperand(
+        MDNode::get(Ctx, {MDString::get(Ctx, ST->getName()),
+                          ConstantAsMetadata::get(UndefValue::get(ST))}));
+  return Entry;
+}
+
+Type *EntryTypeRemapper::remapType(Type *Ty) {
+  if (auto It = Map.find(Ty); It != Map.end())
+    return It->second;
+
+  Type *Mapped = Ty;
+  if (auto *ST = dyn_cast<StructType>(Ty); ST && ST->isLiteral()) {
+    SmallVector<Type *, 8> Elements;
+    for (Type *Elt : ST->elements())
+      Elements.push_back(remapType(Elt));
+    Mapped = StructType::get(Ty->getContext(), Elements, ST->isPacked());
+  } else if (auto *AT = dyn_cast<ArrayType>(Ty)) {
+    Mapped =
+        ArrayType::get(remapType(AT->getElementType()), AT->getNumElements());
+  } else if (auto *VT = dyn_cast<VectorType>(Ty)) {
+    Mapped = VectorType::get(remapType(VT->getElementType()),
+                             VT->getElementCount());
+  } else if (auto *FT = dyn_cast<FunctionType>(Ty)) {
+    SmallVector<Type *, 8> Params;
+    for (Type *Param : FT->params())
+      Params.push_back(remapType(Param));
+    Mapped = FunctionType::get(remapType(FT->getReturnType()), Params,
+                               FT->isVarArg());
+  }
+
+  Map[Ty] = Mapped;
+  return Mapped;
+}
+
+FunctionSplicer::FunctionSplicer(Module &M, Module &Entry)
+    : M(M), Entry(Entry) {
+  LLVMContext &Ctx = M.getContext();
+  if (NamedMDNode *Names = Entry.getNamedMetadata(TypesMDName)) {
+    for (const MDNode *Node : Names->operands()) {
+      auto *Name = dyn_cast<MDString>(Node->getOperand(0));
+      auto *Value = dyn_cast<ConstantAsMetadata>(Node->getOperand(1));
+      StructType *ST = Name ? StructType::getTypeByName(Ctx, Name->getString())
+                            : nullptr;
+      if (!ST || !Value) {
+        Valid = false;
+        return;
+      }
+      Types.Map[Value->getType()] = ST;
+    }
+  }
+
+  // Resolve the globals of the entry before changing anything.
+  for (GlobalValue &GV : Entry.global_values()) {
+    GlobalValue *Target = M.getNamedValue(GV.getName());
+    if (!Target) {
+      auto *Fn = dyn_cast<Function>(&GV);
+      if (!Fn || !Fn->isIntrinsic()) {
+        Valid = false;
+        return;
+      }
+      Intrinsics.push_back(Fn);
+      continue;
+    }
+
+    if (Target->getValueType() != Types.remapType(GV.getValueType())) {
+      Valid = false;
+      return;
+    }
+    VMap[&GV] = Target;
+  }
+}
+
+bool FunctionSplicer::splice(Function &F) {
+  Function *EntryF = Entry.getFunction(F.getName());
+  if (!Valid || !EntryF || EntryF->isDeclaration() ||
+      VMap.lookup(EntryF) != &F)
+    return false;
+
+  for (Function *Fn : Intrinsics) {
+    auto *FTy = cast<FunctionType>(Types.remapType(Fn->getFunctionType()));
+    VMap[Fn] = M.getOrInsertFunction(Fn->getName(), FTy, Fn->getAttributes())
+                   .getCallee();
+  }
+  Intrinsics.clear();
+
+  for (auto [Arg, EntryArg] : zip(F.args(), EntryF->args()))
+    VMap[&EntryArg] = &Arg;
+
+  F.dropAllReferences();
+  SmallVector<ReturnInst *, 8> Returns;
+  CloneFunctionInto(&F, EntryF, VMap, CloneFunctionChangeType::DifferentModule,
+                    Returns, "", nullptr, &Types);
+  return true;
+}
+
+} // end namespace omvll
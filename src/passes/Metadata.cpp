@@ -4,16 +4,20 @@
 //
 
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/Instructions.h"
 
+#include "omvll/log.hpp"
+#include "omvll/omvll_config.hpp"
 #include "omvll/passes/Metadata.hpp"
 #include "omvll/visitvariant.hpp"
 
 using namespace llvm;
 
 static constexpr auto ObfKey = "obf";
+static constexpr auto StampKey = "omvll.passes";
 
 namespace omvll {
 
@@ -109,4 +113,48 @@ bool hasObf(Instruction &I, MetaObfTy M) {
   return false;
 }
 
+// A stamp is a !{!"<pass>", !"<params>"} tuple.
+static bool isStamp(const MDOperand &Op, StringRef Pass, StringRef Params) {
+  auto *Stamp = dyn_cast<MDTuple>(Op.get());
+  if (!Stamp || Stamp->getNumOperands() != 2)
+    return false;
+
+  auto *StampPass = dyn_cast<MDString>(Stamp->getOperand(0));
+  auto *StampParams = dyn_cast<MDString>(Stamp->getOperand(1));
+  return StampPass && StampParams && StampPass->getString() == Pass &&
+         StampParams->getString() == Params;
+}
+
+void addPassStamp(Function &F, StringRef Pass, StringRef Params) {
+  if (hasPassStamp(F, Pass, Params))
+    return;
+
+  LLVMContext &Ctx = F.getContext();
+  SmallVector<Metadata *, 4> Stamps;
+  if (MDNode *Node = F.getMetadata(StampKey))
+    Stamps.append(Node->op_begin(), Node->op_end());
+
+  Stamps.push_back(MDTuple::get(
+      Ctx, {MDString::get(Ctx, Pass), MDString::get(Ctx, Params)}));
+  F.setMetadata(StampKey, MDTuple::get(Ctx, Stamps));
+}
+
+bool hasPassStamp(const Function &F, StringRef Pass, StringRef Params) {
+  MDNode *Node = F.getMetadata(StampKey);
+  if (!Node)
+    return false;
+
+  return any_of(Node->operands(), [&](const MDOperand &Op) {
+    return isStamp(Op, Pass, Params);
+  });
+}
+
+bool isAlreadyObfuscated(const Function &F, StringRef Pass, StringRef Params) {
+  if (!Config.SkipObfuscatedFunctions || !hasPassStamp(F, Pass, Params))
+    return false;
+
+  SINFO("[{}] Skipping function {}: already obfuscated", Pass, F.getName());
+  return true;
+}
+
 } // end namespace omvll
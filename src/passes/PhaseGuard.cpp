@@ -0,0 +1,64 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+
+#include "omvll/log.hpp"
+#include "omvll/passes/PhaseGuard.hpp"
+
+using namespace llvm;
+
+namespace omvll {
+
+static constexpr auto GuardMDName = "omvll.obfuscated";
+
+static StringRef getPhaseName(Phase P) {
+  switch (P) {
+  case Phase::Early:
+    return "early";
+  case Phase::Last:
+    return "last";
+  }
+  llvm_unreachable("Unknown phase");
+}
+
+bool PhaseGuard::isObfuscated(const Module &M, Phase P) {
+  NamedMDNode *Guard = M.getNamedMetadata(GuardMDName);
+  if (!Guard)
+    return false;
+
+  for (const MDNode *Node : Guard->operands()) {
+    if (Node->getNumOperands() != 1)
+      continue;
+    if (auto *Name = dyn_cast<MDString>(Node->getOperand(0)))
+      if (Name->getString() == getPhaseName(P))
+        return true;
+  }
+  return false;
+}
+
+void PhaseGuard::setObfuscated(Module &M, Phase P) {
+  if (isObfuscated(M, P))
+    return;
+
+  LLVMContext &Ctx = M.getContext();
+  NamedMDNode *Guard = M.getOrInsertNamedMetadata(GuardMDName);
+  Guard->addOperand(MDNode::get(Ctx, MDString::get(Ctx, getPhaseName(P))));
+}
+
+PreservedAnalyses PhaseGuard::run(Module &M, ModuleAnalysisManager &MAM) {
+  if (isObfuscated(M, P)) {
+    SINFO("[{}] Skipping module {}: already obfuscated in the {} phase",
+          name(), M.getName(), getPhaseName(P));
+    return PreservedAnalyses::all();
+  }
+
+  PreservedAnalyses PA = MPM.run(M, MAM);
+  setObfuscated(M, P);
+  return PA;
+}
+
+} // end namespace omvll
@@ -3,16 +3,27 @@
 // details.
 //
 
+#include <map>
+#include <mutex>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/Demangle/Demangle.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
 
 #include "omvll/ObfuscationConfig.hpp"
 #include "omvll/PyConfig.hpp"
 #include "omvll/jitter.hpp"
 #include "omvll/log.hpp"
+#include "omvll/omvll_config.hpp"
 #include "omvll/passes/anti-hook/AntiHook.hpp"
 #include "omvll/utils.hpp"
+#include "omvll/versioning.hpp"
 
 using namespace llvm;
 
@@ -24,7 +35,6 @@ namespace omvll {
 
 struct PrologueInfoTy {
   std::string Asm;
-  size_t Size;
 };
 
 // clang-format off
@@ -32,15 +42,77 @@ static const std::vector<PrologueInfoTy> AntiFridaPrologues = {
   {R"delim(
     mov x17, x17;
     mov x16, x16;
-  )delim", 2},
+  )delim"},
 
   {R"delim(
     mov x16, x16;
     mov x17, x17;
-  )delim", 2}
+  )delim"}
 };
 // clang-format on
 
+// The prologues are only injected on AArch64.
+static constexpr size_t InstSize = 4;
+
+// Assembling a prologue sets up the MC layer of the target, whereas there are
+// only a few distinct snippets: memoize the assembled bytes per (snippet,
+// triple) for the lifetime of the process and, if an output folder is
+// configured, on disk across compiler invocations.
+static std::mutex AssembledProloguesMutex;
+static std::map<std::pair<std::string, std::string>, std::string>
+    AssembledPrologues;
+
+static std::string getPrologueCachePath(StringRef Asm, StringRef Triple) {
+  if (Config.OutputFolder.empty())
+    return "";
+
+  // An upgrade of O-MVLL or LLVM may assemble the same snippet differently.
+  std::string Key = OMVLL_VERSION "\n" OMVLL_LLVM_VERSION_STRING "\n";
+  Key += Asm;
+  uint64_t Hash = xxh3_64bits(arrayRefFromStringRef(Key));
+  SmallString<256> Path(Config.OutputFolder);
+  sys::path::append(Path, "cache");
+  sys::path::append(Path,
+                    "omvll-asm-" + Triple + "-" + utohexstr(Hash) + ".bin");
+  return std::string(Path);
+}
+
+std::string AntiHook::getAssembledPrologue(const std::string &Asm,
+                                           const std::string &Triple) {
+  std::lock_guard<std::mutex> Lock(AssembledProloguesMutex);
+  auto It = AssembledPrologues.find({Asm, Triple});
+  if (It != AssembledPrologues.end())
+    return It->second;
+  std::string &Insts = AssembledPrologues[{Asm, Triple}];
+
+  std::string CachePath = getPrologueCachePath(Asm, Triple);
+  if (!CachePath.empty()) {
+    if (auto Buffer = MemoryBuffer::getFile(CachePath);
+        Buffer && (*Buffer)->getBufferSize() > 0 &&
+        (*Buffer)->getBufferSize() % InstSize == 0) {
+      SDEBUG("[{}] Using cached prologue {}", name(), CachePath);
+      return Insts = (*Buffer)->getBuffer().str();
+    }
+  }
+
+  std::unique_ptr<MemoryBuffer> Buffer = Jitter::get(Triple).jitAsm(Asm);
+  if (!Buffer)
+    fatalError("Cannot JIT Anti-Frida prologue: \n" + Asm);
+  Insts = Buffer->getBuffer().str();
+
+  if (!CachePath.empty()) {
+    sys::fs::create_directories(sys::path::parent_path(CachePath));
+    if (Error Err = writeToOutput(CachePath, [&](raw_ostream &OS) {
+          OS << Insts;
+          return Error::success();
+        }))
+      SWARN("[{}] Cannot write prologue cache {}: {}", name(), CachePath,
+            toString(std::move(Err)));
+  }
+
+  return Insts;
+}
+
 bool AntiHook::runOnFunction(Function &F) {
   if (F.getInstructionCount() == 0)
     return false;
@@ -60,13 +132,11 @@ bool AntiHook::runOnFunction(Function &F) {
   size_t Idx = RandomGenerator::generateFullRand() % AntiFridaPrologues.size();
   const PrologueInfoTy &P = AntiFridaPrologues[Idx];
 
-  std::unique_ptr<MemoryBuffer> Insts = JIT->jitAsm(P.Asm, P.Size);
-  if (!Insts)
-    fatalError("Cannot JIT Anti-Frida prologue: \n" + P.Asm);
+  std::string Insts =
+      getAssembledPrologue(P.Asm, getModuleTripleStr(*F.getParent()));
 
   auto *Int8Ty = Type::getInt8Ty(F.getContext());
-  auto *Prologue = ConstantDataVector::getRaw(Insts->getBuffer(),
-                                              Insts->getBufferSize(), Int8Ty);
+  auto *Prologue = ConstantDataVector::getRaw(Insts, Insts.size(), Int8Ty);
   F.setPrologueData(Prologue);
 
   return true;
@@ -81,7 +151,6 @@ PreservedAnalyses AntiHook::run(Module &M, ModuleAnalysisManager &FAM) {
   bool Changed = false;
   PyConfig &Config = PyConfig::instance();
   SINFO("[{}] Executing on module {}", name(), M.getName());
-  JIT = std::make_unique<Jitter>(getModuleTripleStr(M));
 
   for (Function &F : M) {
     if (isFunctionGloballyExcluded(&F) ||
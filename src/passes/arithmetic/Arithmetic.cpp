@@ -280,6 +280,35 @@ bool Arithmetic::runOnFunction(Function &F,
   return Changed;
 }
 
+void Arithmetic::queryConfig(ObfuscationConfig &UserConfig, Function &F) {
+  if (!isFunctionGloballyExcluded(&F))
+    UserConfig.obfuscateArithmetics(F.getParent(), &F);
+}
+
+bool Arithmetic::visitFunction(Function &F) {
+  if (isFunctionGloballyExcluded(&F))
+    return false;
+
+  PyConfig &Config = PyConfig::instance();
+  ArithmeticOpt Opt =
+      Config.getUserConfig()->obfuscateArithmetics(F.getParent(), &F);
+  if (!Opt)
+    return false;
+
+  std::string Params = "rounds=" + std::to_string(Opt.Iterations);
+  if (isAlreadyObfuscated(F, name(), Params))
+    return false;
+
+  SINFO("[{}] Visiting function {}", name(), F.getName());
+  Opts.insert({&F, std::move(Opt)});
+
+  RandomGenerator::FunctionStream Stream(F);
+  bool Changed = runOnFunction(F);
+  if (Changed)
+    addPassStamp(F, name(), Params);
+  return Changed;
+}
+
 PreservedAnalyses Arithmetic::run(Module &M, ModuleAnalysisManager &FAM) {
   if (isModuleGloballyExcluded(&M)) {
     SINFO("Excluding module [{}]", M.getName());
@@ -287,7 +316,6 @@ PreservedAnalyses Arithmetic::run(Module &M, ModuleAnalysisManager &FAM) {
   }
 
   bool Changed = false;
-  PyConfig &Config = PyConfig::instance();
   SINFO("[{}] Executing on module {}", name(), M.getName());
   IRChangesMonitor ModuleChanges(M, name());
 
@@ -299,19 +327,10 @@ PreservedAnalyses Arithmetic::run(Module &M, ModuleAnalysisManager &FAM) {
   std::transform(Functions.begin(), Functions.end(),
                  std::back_inserter(ToVisit), [](auto &F) { return &F; });
 
-  for (Function *F : ToVisit) {
-    if (isFunctionGloballyExcluded(F))
-      continue;
-
-    ArithmeticOpt Opt = Config.getUserConfig()->obfuscateArithmetics(&M, F);
-    if (!Opt)
-      continue;
-
-    SINFO("[{}] Visiting function {}", name(), F->getName());
-    Opts.insert({F, std::move(Opt)});
-
-    Changed |= runOnFunction(*F);
-  }
+  Changed |= beginModule(M);
+  for (Function *F : ToVisit)
+    Changed |= visitFunction(*F);
+  Changed |= endModule(M);
 
   SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
         M.getName());
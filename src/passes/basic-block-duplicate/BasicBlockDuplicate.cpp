@@ -16,6 +16,7 @@
 #include "omvll/ObfuscationConfig.hpp"
 #include "omvll/PyConfig.hpp"
 #include "omvll/log.hpp"
+#include "omvll/passes/Metadata.hpp"
 #include "omvll/passes/basic-block-duplicate/BasicBlockDuplicate.hpp"
 #include "omvll/passes/basic-block-duplicate/BasicBlockDuplicateOpt.hpp"
 #include "omvll/utils.hpp"
@@ -25,28 +26,33 @@ using namespace omvll;
 
 namespace omvll {
 
-static constexpr auto LRand48FunctionName = "lrand48";
 static constexpr unsigned MaxDuplicatedBlocksPerFunction = 500;
 
-static Value *buildCoinflip(IRBuilder<> &Builder, Module &M) {
-    LLVMContext &Ctx = M.getContext();
-
-    AttributeList AL;
-    AL = AL.addFnAttribute(Ctx, Attribute::NoUnwind);
-    auto *I64Ty = Builder.getInt64Ty();
-
-    FunctionCallee LRand48 = M.getOrInsertFunction(LRand48FunctionName, AL, I64Ty);
-
-    Value *Rand = Builder.CreateCall(LRand48);
-    Value *LSB  = Builder.CreateAnd(Rand, ConstantInt::get(I64Ty, 1));
-    return Builder.CreateICmpNE(LSB, ConstantInt::get(I64Ty, 0));
+/// The coinflip is an opaque predicate on the address of a stack slot of the
+/// function, mixed with a per-block constant: it varies across threads, call
+/// depths and runs (ASLR), never touches shared memory, and both branches are
+/// semantically equivalent anyway.
+Value *BasicBlockDuplicate::buildCoinflip(IRBuilder<> &Builder,
+                                          AllocaInst *Slot) {
+  auto *I64Ty = Builder.getInt64Ty();
+  Value *Addr = Builder.CreatePtrToInt(Slot, I64Ty);
+  uint64_t Mix = RandomGenerator::generateFullRand() | 1;
+  Value *X = Builder.CreateMul(Addr, ConstantInt::get(I64Ty, Mix));
+
+  // Branch on the most significant bit, which depends on all the others.
+  return Builder.CreateICmpSLT(X, ConstantInt::get(I64Ty, 0));
 }
 
-bool BasicBlockDuplicate::process(Function &F, LLVMContext &Ctx,
-                                  unsigned Probability) {
+bool BasicBlockDuplicate::process(
+    Function &F, LLVMContext &Ctx,
+    const BasicBlockDuplicateWithProbability &Opt) {
   SmallVector<BasicBlock *, 64> ToDup;
   ToDup.reserve(F.size());
 
+  SmallPtrSet<const BasicBlock *, 16> HotBlocks;
+  if (Opt.SkipHotBlocks)
+    HotBlocks = findHotBlocks(F);
+
   // Collect basic blocks to be duplicated, up to MaxDuplicatedBlocksPerFunction.
   for (BasicBlock &BB : F) {
     if (ToDup.size() >= MaxDuplicatedBlocksPerFunction)
@@ -55,14 +61,23 @@ bool BasicBlockDuplicate::process(Function &F, LLVMContext &Ctx,
       continue;
     if (isEHBlock(BB) || containsSwiftErrorAlloca(BB))
       continue;
-    if (RandomGenerator::checkProbability(Probability))
+    // Avoid duplicating hot blocks, which mostly adds icache pressure.
+    if (HotBlocks.contains(&BB))
+      continue;
+    if (RandomGenerator::checkProbability(Opt.Probability))
       ToDup.push_back(&BB);
   }
 
   if (ToDup.empty())
     return false;
 
+  // The entry block is never duplicated: it holds the stack slot.
+  BasicBlock &Entry = F.getEntryBlock();
   IRBuilder<> Builder(Ctx);
+  Builder.SetInsertPoint(&Entry, Entry.getFirstInsertionPt());
+  AllocaInst *Slot =
+      Builder.CreateAlloca(Builder.getInt8Ty(), nullptr, ".bbdup.slot");
+
   for (BasicBlock *BB : ToDup) {
     Instruction *SplitPt = BB->getFirstNonPHI();
     if (!SplitPt)
@@ -80,7 +95,7 @@ bool BasicBlockDuplicate::process(Function &F, LLVMContext &Ctx,
 
     // Branch on coinflip result.
     Builder.SetInsertPoint(BB);
-    Value *Cond = buildCoinflip(Builder, *F.getParent());
+    Value *Cond = buildCoinflip(Builder, Slot);
     Builder.CreateCondBr(Cond, NewBB, OldBB);
 
     // Ensure existing PNs have an incoming entry for the newly-cloned basic
@@ -163,8 +178,19 @@ PreservedAnalyses BasicBlockDuplicate::run(Module &M,
 
     auto *P = std::get_if<BasicBlockDuplicateWithProbability>(&Opt);
     if (P && !isFunctionGloballyExcluded(&F) && !F.isDeclaration() &&
-        !F.isIntrinsic() && !F.getName().starts_with("__omvll"))
-      Changed |= process(F, Ctx, P->Probability);
+        !F.isIntrinsic() && !F.getName().starts_with("__omvll")) {
+      std::string Params = "probability=" + std::to_string(P->Probability) +
+                           ",skip_hot_blocks=" +
+                           std::to_string(P->SkipHotBlocks);
+      if (isAlreadyObfuscated(F, name(), Params))
+        continue;
+
+      RandomGenerator::FunctionStream Stream(F);
+      if (process(F, Ctx, *P)) {
+        addPassStamp(F, name(), Params);
+        Changed = true;
+      }
+    }
   }
 
   SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
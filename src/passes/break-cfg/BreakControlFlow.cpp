@@ -20,6 +20,7 @@
 #include "omvll/log.hpp"
 #include "omvll/passes/Metadata.hpp"
 #include "omvll/passes/break-cfg/BreakControlFlow.hpp"
+#include "omvll/passes/break-cfg/BreakControlFlowOpt.hpp"
 #include "omvll/utils.hpp"
 
 using namespace llvm;
@@ -72,7 +73,53 @@ static const uint8_t ARMAsmBreakingStub[] = {
     // Pad with NOPs
     0x00, 0xBF, 0x00, 0xBF, 0x00, 0xBF, 0x00, 0xBF, 0x00, 0xBF, 0x00, 0xBF};
 
-bool BreakControlFlow::runOnFunction(Function &F) {
+// Create a new function taking over the body of F, by splicing its basic
+// blocks rather than cloning them. The result matches CloneFunction.
+static Function *moveFunctionBody(Function &F) {
+  Function *NewF = Function::Create(F.getFunctionType(), F.getLinkage(),
+                                    F.getAddressSpace(), F.getName(),
+                                    F.getParent());
+  NewF->copyAttributesFrom(&F);
+
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  F.getAllMetadata(MDs);
+  for (const auto &[Kind, MD] : MDs)
+    NewF->addMetadata(Kind, *MD);
+
+  for (auto [Arg, NewArg] : zip(F.args(), NewF->args())) {
+    NewArg.takeName(&Arg);
+    Arg.replaceAllUsesWith(&NewArg);
+  }
+
+  NewF->splice(NewF->end(), &F);
+  return NewF;
+}
+
+// The trampoline forwards its own arguments to a callee with the very same
+// prototype, which fulfills the musttail requirements, except for arguments
+// whose memory is owned by the caller's frame and arguments passed in
+// dedicated registers: like the implicit swiftcc sret in x8, an sret or inreg
+// argument may live in the register the trampoline jumps through.
+static bool canForceTailCall(const Function &F, const Triple &TT) {
+  // ARM fails hard on musttail calls it cannot lower as such.
+  if (!TT.isAArch64())
+    return false;
+
+  return none_of(F.args(), [](const Argument &Arg) {
+    return Arg.hasInAllocaAttr() || Arg.hasPreallocatedAttr() ||
+           Arg.hasByValAttr() || Arg.hasStructRetAttr() ||
+           Arg.hasAttribute(Attribute::InReg);
+  });
+}
+
+// Parameters recorded in the stamp of an obfuscated function.
+static std::string getStampParams(const BreakControlFlowOpt &Opt) {
+  return "splice_body=" + std::to_string(Opt.SpliceBody) +
+         ",tail_call=" + std::to_string(Opt.TailCall);
+}
+
+bool BreakControlFlow::runOnFunction(Function &F,
+                                     const BreakControlFlowOpt &Opt) {
   if (F.getInstructionCount() == 0)
     return false;
 
@@ -89,9 +136,16 @@ bool BreakControlFlow::runOnFunction(Function &F) {
 
   SINFO("[{}] Visiting function {}", name(), F.getName());
 
-  ValueToValueMapTy VMap;
-  ClonedCodeInfo CCI;
-  Function *ClonedF = CloneFunction(&F, VMap, &CCI);
+  // Block addresses would still refer to F if its blocks were moved.
+  Function *ClonedF = nullptr;
+  if (Opt.SpliceBody &&
+      none_of(F, [](const BasicBlock &BB) { return BB.hasAddressTaken(); })) {
+    ClonedF = moveFunctionBody(F);
+  } else {
+    ValueToValueMapTy VMap;
+    ClonedCodeInfo CCI;
+    ClonedF = CloneFunction(&F, VMap, &CCI);
+  }
   F.deleteBody();
 
   Function &Trampoline = F;
@@ -161,6 +215,10 @@ bool BreakControlFlow::runOnFunction(Function &F) {
   ClonedF->setPrologueData(Prologue);
   ClonedF->setLinkage(GlobalValue::InternalLinkage);
 
+  // Stamp the protected body as well, so that a later phase does not put it
+  // behind a trampoline of its own.
+  addPassStamp(*ClonedF, name(), getStampParams(Opt));
+
   BasicBlock *Entry =
       BasicBlock::Create(Trampoline.getContext(), "Entry", &Trampoline);
   IRBuilder<NoFolder> IRB(Entry);
@@ -208,6 +266,12 @@ bool BreakControlFlow::runOnFunction(Function &F) {
   // the trampoline's jump target overwrites.
   if (CallConv == CallingConv::Swift) {
     Call->setTailCallKind(CallInst::TCK_MustTail);
+  } else if (Opt.TailCall) {
+    // Jump to the protected function rather than calling it, so that the
+    // trampoline frame is released before entering the function.
+    Call->setTailCallKind(canForceTailCall(*ClonedF, TT)
+                              ? CallInst::TCK_MustTail
+                              : CallInst::TCK_Tail);
   }
 
   // Copy parameter attributes from the cloned function to its call-site
@@ -242,24 +306,30 @@ PreservedAnalyses BreakControlFlow::run(Module &M, ModuleAnalysisManager &FAM) {
   PyConfig &Config = PyConfig::instance();
   SINFO("[{}] Executing on module {}", name(), M.getName());
 
-  std::vector<Function *> ToVisit;
+  std::vector<std::pair<Function *, BreakControlFlowOpt>> ToVisit;
   for (Function &F : M) {
     if (isFunctionGloballyExcluded(&F) || F.isDeclaration() ||
         F.isIntrinsic() || F.getName().starts_with("__omvll"))
       continue;
 
-    if (Config.getUserConfig()->breakControlFlow(&M, &F))
-      ToVisit.emplace_back(&F);
+    BreakControlFlowOpt Opt = Config.getUserConfig()->breakControlFlow(&M, &F);
+    if (Opt && !isAlreadyObfuscated(F, name(), getStampParams(Opt)))
+      ToVisit.emplace_back(&F, Opt);
   }
 
   if (ToVisit.empty())
     return PreservedAnalyses::all();
 
-  JIT = std::make_unique<Jitter>(getModuleTripleStr(M));
+  JIT = &Jitter::get(getModuleTripleStr(M));
 
   unsigned int NumVisits = 0;
-  for (Function *F : ToVisit)
-    NumVisits += runOnFunction(*F);
+  for (const auto &[F, Opt] : ToVisit) {
+    if (!runOnFunction(*F, Opt))
+      continue;
+
+    addPassStamp(*F, name(), getStampParams(Opt));
+    ++NumVisits;
+  }
 
   SINFO("[{}] Total of {} functions were modified on module {}", name(),
         NumVisits, M.getName());
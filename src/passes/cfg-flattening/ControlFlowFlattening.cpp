@@ -18,6 +18,7 @@
 #include "omvll/ObfuscationConfig.hpp"
 #include "omvll/PyConfig.hpp"
 #include "omvll/log.hpp"
+#include "omvll/passes/Metadata.hpp"
 #include "omvll/passes/cfg-flattening/ControlFlowFlattening.hpp"
 #include "omvll/utils.hpp"
 
@@ -489,12 +490,15 @@ PreservedAnalyses ControlFlowFlattening::run(Module &M,
         F.getName().starts_with("__omvll"))
       continue;
 
-    if (isCoroutine(&F))
+    if (isCoroutine(&F) || isAlreadyObfuscated(F, name()))
       continue;
 
+    RandomGenerator::FunctionStream Stream(F);
     bool MadeChange = runOnFunction(F);
-    if (MadeChange)
+    if (MadeChange) {
       reg2mem(F);
+      addPassStamp(F, name());
+    }
 
     Changed |= MadeChange;
   }
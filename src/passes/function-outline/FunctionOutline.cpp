@@ -3,10 +3,16 @@
 // details.
 //
 
+#include <limits>
+#include <optional>
+
+#include "llvm/ADT/SetVector.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Transforms/Utils/CodeExtractor.h"
 
 #include "omvll/ObfuscationConfig.hpp"
@@ -21,6 +27,8 @@ using namespace omvll;
 
 namespace omvll {
 
+static constexpr unsigned MaxOutlinedRegionSize = 8;
+
 static bool isStackFrameDependentIntrinsic(Intrinsic::ID ID) {
   switch (ID) {
   case Intrinsic::vastart:
@@ -79,10 +87,7 @@ static bool hasAllocaInputWithLifetime(const SetVector<Value *> &Inputs) {
   return false;
 }
 
-static bool isOutlineCandidate(const BasicBlock &BB) {
-  if (BB.size() < 3)
-    return false;
-
+static bool canBeOutlined(const BasicBlock &BB) {
   if (BB.hasAddressTaken() || isEHBlock(BB) || containsSwiftErrorAlloca(BB) ||
       outliningMayBeUnfavorable(BB))
     return false;
@@ -93,6 +98,78 @@ static bool isOutlineCandidate(const BasicBlock &BB) {
   return true;
 }
 
+static bool isOutlineCandidate(const BasicBlock &BB) {
+  return BB.size() >= 3 && canBeOutlined(BB);
+}
+
+/// Number of inputs and outputs of Region once outlined, the maximum if it
+/// cannot be extracted.
+static unsigned getInterfaceSize(ArrayRef<BasicBlock *> Region) {
+  CodeExtractor CE(Region);
+  if (!CE.isEligible())
+    return std::numeric_limits<unsigned>::max();
+  SetVector<Value *> Inputs, Outputs, SinkCands;
+  CE.findInputsOutputs(Inputs, Outputs, SinkCands);
+  return Inputs.size() + Outputs.size();
+}
+
+static unsigned getNumExits(const SmallSetVector<BasicBlock *, 8> &Region) {
+  SmallPtrSet<BasicBlock *, 4> Exits;
+  for (BasicBlock *BB : Region)
+    for (BasicBlock *Succ : successors(BB))
+      if (!Region.count(Succ))
+        Exits.insert(Succ);
+  return Exits.size();
+}
+
+/// Grow a single-entry region from Seed, by absorbing successors whose
+/// predecessors all belong to the region, picking at each step the one that
+/// yields the smallest number of inputs and outputs. Among the single-exit
+/// regions met along the way, keep the largest one whose inputs and outputs
+/// do not outnumber the ones of outlining its blocks individually.
+static SmallVector<BasicBlock *, 8>
+growRegion(BasicBlock *Seed,
+           function_ref<bool(const BasicBlock &)> IsGrowthCandidate) {
+  SmallSetVector<BasicBlock *, 8> Region;
+  Region.insert(Seed);
+
+  SmallVector<BasicBlock *, 8> Best{Seed};
+  unsigned SeparateCost = getInterfaceSize(Best);
+
+  while (Region.size() < MaxOutlinedRegionSize) {
+    BasicBlock *Next = nullptr;
+    unsigned NextCost = std::numeric_limits<unsigned>::max();
+    for (BasicBlock *BB : Region) {
+      for (BasicBlock *Succ : successors(BB)) {
+        if (Region.count(Succ) || succ_empty(Succ) ||
+            !IsGrowthCandidate(*Succ))
+          continue;
+        if (!all_of(predecessors(Succ),
+                    [&](BasicBlock *Pred) { return Region.count(Pred); }))
+          continue;
+
+        Region.insert(Succ);
+        unsigned Cost = getInterfaceSize(Region.getArrayRef());
+        Region.pop_back();
+        if (Cost < NextCost) {
+          Next = Succ;
+          NextCost = Cost;
+        }
+      }
+    }
+
+    if (!Next)
+      break;
+
+    Region.insert(Next);
+    SeparateCost = SaturatingAdd(SeparateCost, getInterfaceSize({Next}));
+    if (getNumExits(Region) <= 1 && NextCost <= SeparateCost)
+      Best.assign(Region.begin(), Region.end());
+  }
+
+  return Best;
+}
+
 static bool
 hasSwiftErrorOrSwiftSelfAttribute(const SetVector<Value *> &Inputs) {
   for (Value *V : Inputs) {
@@ -125,20 +202,25 @@ static void eraseLifetimeMarkers(Function *F) {
 }
 
 bool FunctionOutline::process(Function &F, LLVMContext &Ctx,
-                              unsigned Probability) {
+                              const FunctionOutlineWithProbability &Opt) {
   SmallVector<BasicBlock *, 32> ToOutline;
   ToOutline.reserve(F.size());
 
+  // Outlining a hot block would add a call on the hot path.
+  SmallPtrSet<const BasicBlock *, 16> HotBlocks;
+  if (Opt.SkipHotBlocks)
+    HotBlocks = findHotBlocks(F);
+
   // Collect basic blocks to outline.
   auto ShouldOutline = [&]() {
-    return RandomGenerator::generate() < Probability;
+    return RandomGenerator::generate() < Opt.Probability;
   };
   for (BasicBlock &BB : F) {
     if (&BB == &F.getEntryBlock())
       continue;
     // Some further checks in addition to the ones in
     // `CodeExtractor::isEligible`.
-    if (!isOutlineCandidate(BB))
+    if (!isOutlineCandidate(BB) || HotBlocks.contains(&BB))
       continue;
     if (ShouldOutline())
       ToOutline.push_back(&BB);
@@ -147,9 +229,33 @@ bool FunctionOutline::process(Function &F, LLVMContext &Ctx,
   if (ToOutline.empty())
     return false;
 
-  unsigned Outlined = 0;
+  // Build the regions to outline, either single blocks or, when requested,
+  // SESE subgraphs grown from the selected blocks.
+  SmallVector<SmallVector<BasicBlock *, 8>, 32> Regions;
+  SmallPtrSet<const BasicBlock *, 32> Claimed;
+  auto IsGrowthCandidate = [&](const BasicBlock &BB) {
+    return &BB != &F.getEntryBlock() && !Claimed.contains(&BB) &&
+           !HotBlocks.contains(&BB) && canBeOutlined(BB);
+  };
   for (BasicBlock *BB : ToOutline) {
-    SmallVector<BasicBlock *, 1> Region{BB};
+    if (Claimed.contains(BB))
+      continue;
+    auto &Region = Regions.emplace_back();
+    if (Opt.GrowRegions)
+      Region = growRegion(BB, IsGrowthCandidate);
+    else
+      Region.push_back(BB);
+    Claimed.insert(Region.begin(), Region.end());
+  }
+
+  // Scanning the function to build the analysis cache is linear in its size:
+  // build it once, lazily, and share it across all the extractions. Like in
+  // HotColdSplitting, the cached data remains valid for the blocks still to be
+  // extracted, as previous extractions only move other blocks out of F.
+  std::optional<CodeExtractorAnalysisCache> CEAC;
+
+  unsigned Outlined = 0;
+  for (ArrayRef<BasicBlock *> Region : Regions) {
     CodeExtractor CE(Region);
     // Missed something?
     if (!CE.isEligible())
@@ -167,13 +273,14 @@ bool FunctionOutline::process(Function &F, LLVMContext &Ctx,
     if (hasAllocaInputWithLifetime(Inputs))
       continue;
 
-    // Outline region and replace the original block with a call-site to the
+    // Outline region and replace the original blocks with a call-site to the
     // newly-created function.
-    CodeExtractorAnalysisCache CEAC(F);
-    if (auto *OutlinedFn = CE.extractCodeRegion(CEAC)) {
+    if (!CEAC)
+      CEAC.emplace(F);
+    if (auto *OutlinedFn = CE.extractCodeRegion(*CEAC)) {
       SDEBUG("[{}] New outlined function {}", name(), OutlinedFn->getName());
       eraseLifetimeMarkers(OutlinedFn);
-      ++Outlined;
+      Outlined += Region.size();
     }
   }
 
@@ -197,7 +304,7 @@ PreservedAnalyses FunctionOutline::run(Module &M, ModuleAnalysisManager &MAM) {
   PyConfig &Config = PyConfig::instance();
   SINFO("[{}] Executing on module {}", name(), M.getName());
 
-  std::vector<std::pair<Function *, unsigned>> ToVisit;
+  std::vector<std::pair<Function *, FunctionOutlineWithProbability>> ToVisit;
   for (Function &F : M) {
     FunctionOutlineOpt Opt = Config.getUserConfig()->functionOutline(&M, &F);
 
@@ -205,7 +312,7 @@ PreservedAnalyses FunctionOutline::run(Module &M, ModuleAnalysisManager &MAM) {
     if (P && !isFunctionGloballyExcluded(&F) && !F.isDeclaration() &&
         !F.isIntrinsic() && !F.getName().starts_with("__omvll") &&
         !isCoroutine(&F))
-      ToVisit.emplace_back(&F, P->Probability);
+      ToVisit.emplace_back(&F, *P);
   }
 
   if (ToVisit.empty())
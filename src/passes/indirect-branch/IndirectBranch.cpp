@@ -4,8 +4,10 @@
 //
 
 #include <cassert>
+#include <numeric>
 #include <random>
 
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/ScopeExit.h"
@@ -14,10 +16,13 @@
 #include "llvm/IR/DerivedTypes.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Instructions.h"
+#include "llvm/Support/MathExtras.h"
 
 #include "omvll/ObfuscationConfig.hpp"
 #include "omvll/PyConfig.hpp"
 #include "omvll/log.hpp"
+#include "omvll/omvll_config.hpp"
+#include "omvll/passes/Metadata.hpp"
 #include "omvll/passes/indirect-branch/IndirectBranch.hpp"
 #include "omvll/passes/indirect-branch/IndirectBranchOpt.hpp"
 #include "omvll/utils.hpp"
@@ -27,8 +32,260 @@ using namespace omvll;
 
 namespace omvll {
 
+// Switches whose case values cover at least this percentage of the range
+// [Min, Max] are lowered through a directly indexed table, all the others
+// through a perfect hash.
+static constexpr uint64_t MinDenseSwitchDensity = 40;
+static constexpr unsigned MaxDenseSwitchRangeBits = 24;
+static constexpr unsigned MaxPerfectHashCases = 1 << 16;
+static constexpr unsigned MaxPerfectHashAttempts = 32;
+
+static IntegerType *getTableEntryType(LLVMContext &Ctx, uint64_t MaxValue) {
+  if (isUInt<8>(MaxValue))
+    return Type::getInt8Ty(Ctx);
+  if (isUInt<16>(MaxValue))
+    return Type::getInt16Ty(Ctx);
+  return Type::getInt32Ty(Ctx);
+}
+
+static GlobalVariable *createSwitchTable(Module &M, IntegerType *EltTy,
+                                         ArrayRef<uint64_t> Values,
+                                         const Twine &Name) {
+  SmallVector<Constant *, 64> Elts;
+  Elts.reserve(Values.size());
+  for (uint64_t V : Values)
+    Elts.push_back(ConstantInt::get(EltTy, V));
+
+  auto *ArrayTy = ArrayType::get(EltTy, Elts.size());
+  return new GlobalVariable(M, ArrayTy, true, GlobalValue::PrivateLinkage,
+                            ConstantArray::get(ArrayTy, Elts), Name);
+}
+
+static Value *loadSwitchTableEntry(IRBuilder<> &Builder, GlobalVariable *Table,
+                                   Value *Idx) {
+  auto *ArrayTy = cast<ArrayType>(Table->getValueType());
+  Value *Ptr = Builder.CreateInBoundsGEP(
+      ArrayTy, Table, {ConstantInt::get(Idx->getType(), 0), Idx});
+  return Builder.CreateLoad(ArrayTy->getElementType(), Ptr);
+}
+
+// Multiplicative hash of a 64-bit key, keeping the top Bits bits.
+static uint64_t hashSwitchKey(uint64_t Key, uint64_t Mul, unsigned Bits) {
+  return (Key * Mul) >> (64 - Bits);
+}
+
+static Value *emitHashSwitchKey(IRBuilder<> &Builder, Value *Key, uint64_t Mul,
+                                unsigned Bits) {
+  Value *Prod = Builder.CreateMul(Key, Builder.getInt64(Mul));
+  return Builder.CreateLShr(Prod, 64 - Bits);
+}
+
+using SwitchCase = std::pair<APInt, unsigned>;
+
+// Case values within a small range: subtract the minimum, bound-check the
+// offset and fetch the jump table slot from a secondary index table whose
+// entries are XOR-encoded.
+static Value *lowerDenseSwitch(IRBuilder<> &Builder, SwitchInst &SI,
+                               ArrayRef<SwitchCase> Cases, uint64_t Range,
+                               unsigned DefaultSlot, IntegerType *SlotTy,
+                               uint64_t SlotKey, Type *IndexTy) {
+  Value *Cond = SI.getCondition();
+  auto *CondTy = cast<IntegerType>(Cond->getType());
+  const APInt &Min = Cases.front().first;
+
+  SmallVector<uint64_t, 64> Entries(Range, DefaultSlot ^ SlotKey);
+  for (const auto &[CaseVal, Slot] : Cases)
+    Entries[(CaseVal - Min).getZExtValue()] = Slot ^ SlotKey;
+
+  GlobalVariable *IndexTable = createSwitchTable(
+      *SI.getModule(), SlotTy, Entries, "indbr.switch_index");
+
+  Value *Offset = Builder.CreateSub(Cond, ConstantInt::get(CondTy, Min));
+  Value *InRange =
+      Builder.CreateICmpULE(Offset, ConstantInt::get(CondTy, Range - 1));
+  Value *Clamped =
+      Builder.CreateSelect(InRange, Offset, ConstantInt::get(CondTy, 0));
+
+  Value *Encoded = loadSwitchTableEntry(
+      Builder, IndexTable, Builder.CreateZExtOrTrunc(Clamped, IndexTy));
+  Value *Slot = Builder.CreateZExt(
+      Builder.CreateXor(Encoded, ConstantInt::get(SlotTy, SlotKey)), IndexTy);
+  return Builder.CreateSelect(InRange, Slot,
+                              ConstantInt::get(IndexTy, DefaultSlot));
+}
+
+// Sparse case values: hash-and-displace perfect hash. The key is first hashed
+// into a bucket holding a displacement, which is XORed with a second hash of
+// the key to get a collision-free position in the keys and slots tables.
+static Value *lowerSparseSwitch(IRBuilder<> &Builder, SwitchInst &SI,
+                                ArrayRef<SwitchCase> Cases,
+                                unsigned DefaultSlot, IntegerType *SlotTy,
+                                uint64_t SlotKey, Type *IndexTy) {
+  if (Cases.size() > MaxPerfectHashCases)
+    return nullptr;
+
+  const unsigned Bits = std::max(2u, Log2_64_Ceil(Cases.size()) + 1);
+  const unsigned BucketBits = Bits - 1;
+  const uint64_t Size = 1ULL << Bits;
+  const uint64_t NumBuckets = 1ULL << BucketBits;
+
+  SmallVector<uint64_t, 64> Disp(NumBuckets, 0);
+  SmallVector<int64_t, 64> Position(Size, -1);
+  uint64_t BucketMul = 0, SlotMul = 0;
+  bool Found = false;
+
+  for (unsigned Attempt = 0; Attempt < MaxPerfectHashAttempts && !Found;
+       ++Attempt) {
+    BucketMul = RandomGenerator::generateFullRand() | 1;
+    SlotMul = RandomGenerator::generateFullRand() | 1;
+
+    std::vector<SmallVector<unsigned, 4>> Buckets(NumBuckets);
+    for (auto [Idx, Case] : enumerate(Cases))
+      Buckets[hashSwitchKey(Case.first.getZExtValue(), BucketMul, BucketBits)]
+          .push_back(Idx);
+
+    SmallVector<unsigned, 64> Order(NumBuckets);
+    std::iota(Order.begin(), Order.end(), 0);
+    llvm::stable_sort(Order, [&](unsigned L, unsigned R) {
+      return Buckets[L].size() > Buckets[R].size();
+    });
+
+    std::fill(Disp.begin(), Disp.end(), 0);
+    std::fill(Position.begin(), Position.end(), -1);
+    BitVector Taken(Size);
+    Found = true;
+
+    for (unsigned B : Order) {
+      if (Buckets[B].empty())
+        break;
+
+      bool Placed = false;
+      SmallVector<uint64_t, 4> Slots;
+      for (uint64_t D = 0; D < Size && !Placed; ++D) {
+        Slots.clear();
+        Placed = true;
+        for (unsigned Idx : Buckets[B]) {
+          uint64_t Pos =
+              hashSwitchKey(Cases[Idx].first.getZExtValue(), SlotMul, Bits) ^ D;
+          if (Taken[Pos] || is_contained(Slots, Pos)) {
+            Placed = false;
+            break;
+          }
+          Slots.push_back(Pos);
+        }
+        if (Placed) {
+          Disp[B] = D;
+          for (auto [Idx, Pos] : zip(Buckets[B], Slots)) {
+            Taken.set(Pos);
+            Position[Pos] = Idx;
+          }
+        }
+      }
+
+      if (!Placed) {
+        Found = false;
+        break;
+      }
+    }
+  }
+
+  if (!Found)
+    return nullptr;
+
+  Value *Cond = SI.getCondition();
+  auto *CondTy = cast<IntegerType>(Cond->getType());
+  SmallVector<uint64_t, 64> Keys(Size, 0), Slots(Size, DefaultSlot ^ SlotKey);
+  for (auto [Pos, Idx] : enumerate(Position)) {
+    if (Idx < 0)
+      continue;
+    Keys[Pos] = Cases[Idx].first.getZExtValue();
+    Slots[Pos] = Cases[Idx].second ^ SlotKey;
+  }
+
+  Module &M = *SI.getModule();
+  LLVMContext &Ctx = M.getContext();
+  GlobalVariable *DispTable = createSwitchTable(
+      M, getTableEntryType(Ctx, Size - 1), Disp, "indbr.switch_disp");
+  GlobalVariable *KeysTable =
+      createSwitchTable(M, CondTy, Keys, "indbr.switch_keys");
+  GlobalVariable *SlotsTable =
+      createSwitchTable(M, SlotTy, Slots, "indbr.switch_index");
+
+  Value *Key = Builder.CreateZExt(Cond, Builder.getInt64Ty());
+  Value *Bucket = emitHashSwitchKey(Builder, Key, BucketMul, BucketBits);
+  Value *D = Builder.CreateZExt(
+      loadSwitchTableEntry(Builder, DispTable,
+                           Builder.CreateZExtOrTrunc(Bucket, IndexTy)),
+      Builder.getInt64Ty());
+  Value *Pos = Builder.CreateZExtOrTrunc(
+      Builder.CreateXor(emitHashSwitchKey(Builder, Key, SlotMul, Bits), D),
+      IndexTy);
+
+  Value *Match = Builder.CreateICmpEQ(
+      loadSwitchTableEntry(Builder, KeysTable, Pos), Cond);
+  Value *Encoded = loadSwitchTableEntry(Builder, SlotsTable, Pos);
+  Value *Slot = Builder.CreateZExt(
+      Builder.CreateXor(Encoded, ConstantInt::get(SlotTy, SlotKey)), IndexTy);
+  return Builder.CreateSelect(Match, Slot,
+                              ConstantInt::get(IndexTy, DefaultSlot));
+}
+
+/// Compute the jump table slot of the successor taken by a switch in O(1),
+/// rather than through an icmp + select chain across every case. Returns
+/// nullptr if the switch cannot be lowered this way.
+static Value *lowerSwitchToSlot(IRBuilder<> &Builder, SwitchInst &SI,
+                                DenseMap<BasicBlock *, unsigned> &BlockToIdx,
+                                Type *IndexTy) {
+  auto *CondTy = cast<IntegerType>(SI.getCondition()->getType());
+  if (SI.getNumCases() == 0 || CondTy->getBitWidth() > 64)
+    return nullptr;
+
+  SmallVector<SwitchCase, 32> Cases;
+  Cases.reserve(SI.getNumCases());
+  for (const auto &Case : SI.cases())
+    Cases.emplace_back(Case.getCaseValue()->getValue(),
+                       BlockToIdx[Case.getCaseSuccessor()]);
+
+  llvm::sort(Cases, [](const SwitchCase &L, const SwitchCase &R) {
+    return L.first.slt(R.first);
+  });
+
+  unsigned DefaultSlot = BlockToIdx[SI.getDefaultDest()];
+  IntegerType *SlotTy =
+      getTableEntryType(SI.getContext(), BlockToIdx.size() - 1);
+  uint64_t SlotKey = RandomGenerator::generateRange(1, SlotTy->getBitMask());
+
+  // Max - Min cannot wrap, given the cases are sorted in signed order.
+  APInt Span = Cases.back().first - Cases.front().first;
+  if (Span.getActiveBits() <= MaxDenseSwitchRangeBits) {
+    uint64_t Range = Span.getZExtValue() + 1;
+    if (Range * MinDenseSwitchDensity <= Cases.size() * 100)
+      return lowerDenseSwitch(Builder, SI, Cases, Range, DefaultSlot, SlotTy,
+                              SlotKey, IndexTy);
+  }
+
+  return lowerSparseSwitch(Builder, SI, Cases, DefaultSlot, SlotTy, SlotKey,
+                           IndexTy);
+}
+
+static GlobalVariable *createJumpTable(Module &M, Type *EltTy,
+                                      ArrayRef<Constant *> Entries,
+                                      const Twine &Name) {
+  auto *ArrayTy = ArrayType::get(EltTy, Entries.size());
+  auto *JumpTable =
+      new GlobalVariable(M, ArrayTy, true, GlobalValue::PrivateLinkage,
+                         ConstantArray::get(ArrayTy, Entries), Name);
+
+  JumpTable->setAlignment(Align(8));
+  JumpTable->setUnnamedAddr(GlobalValue::UnnamedAddr::None);
+  if (Triple(M.getTargetTriple()).isiOS())
+    JumpTable->setSection("__DATA,__const");
+  return JumpTable;
+}
+
 bool IndirectBranch::process(Function &F, const DataLayout &DL,
-                             LLVMContext &Ctx) {
+                             LLVMContext &Ctx, const IndirectBranchConfig &Opt,
+                             unsigned ShuffleSeed) {
   Module &M = *F.getParent();
   std::vector<Instruction *> TerminatorsToReplace;
   SmallPtrSet<BasicBlock *, 32> SuccBlocks;
@@ -53,19 +310,37 @@ bool IndirectBranch::process(Function &F, const DataLayout &DL,
     ShuffledBlockAddrs.emplace_back(BlockAddress::get(Succ));
 
   std::shuffle(ShuffledBlockAddrs.begin(), ShuffledBlockAddrs.end(),
-               std::default_random_engine(Seed));
+               std::default_random_engine(ShuffleSeed));
+
+  // Build a jump table with the shuffled BBs addresses as targets. Masked
+  // entries hold the address plus a per-function key, which is subtracted
+  // back once loaded. XOR would be preferable, but it cannot be expressed
+  // through relocations.
+  GlobalVariable *JumpTable = nullptr;
+  Constant *MaskKey = nullptr;
+  if (Opt.MaskEntries) {
+    auto *IntPtrTy = DL.getIntPtrType(Ctx);
+    MaskKey = ConstantInt::get(
+        IntPtrTy, RandomGenerator::generateRange(1, 0x1FFFFFFF) << 3);
+
+    std::vector<Constant *> MaskedBlockAddrs;
+    MaskedBlockAddrs.reserve(ShuffledBlockAddrs.size());
+    for (Constant *C : ShuffledBlockAddrs)
+      MaskedBlockAddrs.emplace_back(ConstantExpr::getAdd(
+          ConstantExpr::getPtrToInt(C, IntPtrTy), MaskKey));
+
+    JumpTable = createJumpTable(M, IntPtrTy, MaskedBlockAddrs,
+                                "indbr.masked_block_addresses");
+  } else {
+    JumpTable = createJumpTable(M, PointerType::getUnqual(Ctx),
+                                ShuffledBlockAddrs, "indbr.block_addresses");
+  }
 
-  // Build a jump table with the shuffled BBs addresses as targets.
-  auto *ArrayTy =
-      ArrayType::get(PointerType::getUnqual(Ctx), ShuffledBlockAddrs.size());
-  auto *JumpTable = new GlobalVariable(
-      M, ArrayTy, true, GlobalValue::PrivateLinkage,
-      ConstantArray::get(ArrayTy, ShuffledBlockAddrs), "indbr.block_addresses");
-
-  JumpTable->setAlignment(Align(8));
-  JumpTable->setUnnamedAddr(GlobalValue::UnnamedAddr::None);
-  if (Triple(M.getTargetTriple()).isiOS())
-    JumpTable->setSection("__DATA,__const");
+  // Tables to be merged are only placeholders for a slice of the module-wide
+  // table, see mergeJumpTables().
+  if (Opt.MergeTables)
+    (Opt.MaskEntries ? MaskedTablesToMerge : TablesToMerge)
+        .push_back(JumpTable);
 
   DenseMap<BasicBlock *, unsigned> BlockToIdx;
   auto Cleanup = make_scope_exit([&]() {
@@ -108,20 +383,33 @@ bool IndirectBranch::process(Function &F, const DataLayout &DL,
       else
         LoadFrom = CreateGEPForIdx(BI->getSuccessor(0));
     } else if (auto *SI = dyn_cast<SwitchInst>(TI)) {
-      LoadFrom = CreateGEPForIdx(SI->getDefaultDest());
-
-      for (const auto &Case : SI->cases()) {
-        Value *Cond =
-            Builder.CreateICmpEQ(SI->getCondition(), Case.getCaseValue());
-        LoadFrom = Builder.CreateSelect(
-            Cond, CreateGEPForIdx(Case.getCaseSuccessor()), LoadFrom);
+      if (Value *Slot = lowerSwitchToSlot(Builder, *SI, BlockToIdx, IndexTy)) {
+        LoadFrom = Builder.CreateInBoundsGEP(JumpTable->getValueType(),
+                                             JumpTable, {Zero, Slot});
+      } else {
+        // Fallback to a select chain across every case.
+        LoadFrom = CreateGEPForIdx(SI->getDefaultDest());
+
+        for (const auto &Case : SI->cases()) {
+          Value *Cond =
+              Builder.CreateICmpEQ(SI->getCondition(), Case.getCaseValue());
+          LoadFrom = Builder.CreateSelect(
+              Cond, CreateGEPForIdx(Case.getCaseSuccessor()), LoadFrom);
+        }
       }
     }
 
     assert(LoadFrom && "Expecting a valid address value.");
-    auto *IBI = Builder.CreateIndirectBr(
-        Builder.CreateLoad(Builder.getPtrTy(), LoadFrom),
-        TI->getNumSuccessors());
+    Value *Target = nullptr;
+    if (MaskKey) {
+      Value *Masked = Builder.CreateLoad(MaskKey->getType(), LoadFrom);
+      Target = Builder.CreateIntToPtr(Builder.CreateSub(Masked, MaskKey),
+                                      Builder.getPtrTy());
+    } else {
+      Target = Builder.CreateLoad(Builder.getPtrTy(), LoadFrom);
+    }
+
+    auto *IBI = Builder.CreateIndirectBr(Target, TI->getNumSuccessors());
 
     for (auto *Succ : successors(TI->getParent()))
       IBI->addDestination(Succ);
@@ -135,6 +423,86 @@ bool IndirectBranch::process(Function &F, const DataLayout &DL,
   return Replaced > 0;
 }
 
+/// Pack the per-function jump tables contiguously into a single module-wide
+/// table, so that dispatch loads share cache lines and pages. Every former
+/// table is replaced with its slice within the merged one.
+static bool mergeJumpTables(Module &M, ArrayRef<GlobalVariable *> Tables,
+                            const Twine &Name) {
+  if (Tables.size() < 2)
+    return false;
+
+  const auto &DL = M.getDataLayout();
+  Type *EltTy =
+      cast<ArrayType>(Tables.front()->getValueType())->getElementType();
+  std::vector<Constant *> Entries;
+  std::vector<uint64_t> Offsets;
+  for (GlobalVariable *GV : Tables) {
+    Offsets.push_back(Entries.size());
+    Constant *Init = GV->getInitializer();
+    for (unsigned Idx = 0, E = GV->getValueType()->getArrayNumElements();
+         Idx < E; ++Idx)
+      Entries.push_back(Init->getAggregateElement(Idx));
+  }
+
+  GlobalVariable *Merged = createJumpTable(M, EltTy, Entries, Name);
+  Type *IndexTy = DL.getIndexType(Merged->getType());
+  for (auto [GV, Offset] : zip(Tables, Offsets)) {
+    Constant *Indices[] = {ConstantInt::get(IndexTy, 0),
+                           ConstantInt::get(IndexTy, Offset)};
+    GV->replaceAllUsesWith(ConstantExpr::getInBoundsGetElementPtr(
+        Merged->getValueType(), Merged, Indices));
+    GV->eraseFromParent();
+  }
+
+  return true;
+}
+
+bool IndirectBranch::beginModule(Module &) {
+  Seed = RandomGenerator::generate();
+  return false;
+}
+
+bool IndirectBranch::visitFunction(Function &F) {
+  PyConfig &Config = PyConfig::instance();
+  IndirectBranchOpt Opt =
+      Config.getUserConfig()->indirectBranch(F.getParent(), &F);
+  if (!Opt || !*Opt)
+    return false;
+
+  if (isCoroutine(&F))
+    return false;
+
+  if (isFunctionGloballyExcluded(&F) ||
+      F.hasFnAttribute(Attribute::AlwaysInline) || F.isDeclaration() ||
+      F.isIntrinsic() || F.getName().starts_with("__omvll"))
+    return false;
+
+  std::string Params = "merge_tables=" + std::to_string(Opt->MergeTables) +
+                       ",mask_entries=" + std::to_string(Opt->MaskEntries);
+  if (isAlreadyObfuscated(F, name(), Params))
+    return false;
+
+  RandomGenerator::FunctionStream Stream(F);
+  // Without per-function seeds, the functions share the seed of the module,
+  // which keeps the output of the existing configurations.
+  unsigned ShuffleSeed =
+      omvll::Config.PerFunctionSeeds ? RandomGenerator::generate() : Seed;
+  bool Changed = process(F, F.getParent()->getDataLayout(), F.getContext(),
+                         *Opt, ShuffleSeed);
+  if (Changed)
+    addPassStamp(F, name(), Params);
+  return Changed;
+}
+
+bool IndirectBranch::endModule(Module &M) {
+  mergeJumpTables(M, TablesToMerge, "indbr.merged_block_addresses");
+  mergeJumpTables(M, MaskedTablesToMerge,
+                  "indbr.merged_masked_block_addresses");
+  TablesToMerge.clear();
+  MaskedTablesToMerge.clear();
+  return false;
+}
+
 PreservedAnalyses IndirectBranch::run(Module &M, ModuleAnalysisManager &MAM) {
   if (isModuleGloballyExcluded(&M)) {
     SINFO("Excluding module [{}]", M.getName());
@@ -142,27 +510,12 @@ PreservedAnalyses IndirectBranch::run(Module &M, ModuleAnalysisManager &MAM) {
   }
 
   bool Changed = false;
-  PyConfig &Config = PyConfig::instance();
-  Seed = RandomGenerator::generate();
-  LLVMContext &Ctx = M.getContext();
-  const auto &DL = M.getDataLayout();
   SINFO("[{}] Executing on module {}", name(), M.getName());
 
-  for (Function &F : M) {
-    IndirectBranchOpt Opt = Config.getUserConfig()->indirectBranch(&M, &F);
-    if (!Opt || !*Opt)
-      continue;
-
-    if (isCoroutine(&F))
-      continue;
-
-    if (isFunctionGloballyExcluded(&F) ||
-        F.hasFnAttribute(Attribute::AlwaysInline) || F.isDeclaration() ||
-        F.isIntrinsic() || F.getName().starts_with("__omvll"))
-      continue;
-
-    Changed |= process(F, DL, Ctx);
-  }
+  Changed |= beginModule(M);
+  for (Function &F : M)
+    Changed |= visitFunction(F);
+  Changed |= endModule(M);
 
   SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
         M.getName());
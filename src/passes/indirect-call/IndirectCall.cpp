@@ -3,6 +3,10 @@
 // details.
 //
 
+#include <optional>
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
@@ -24,21 +28,9 @@ static uint32_t getRandomShareAligned() {
   return RandomGenerator::generateRange(1, Max) & 0xFFFFFF00ULL;
 }
 
-/// This pass rewrites direct calls into an indirect call through an address
-/// reconstructed given two random shares:
-///
-///   Address = Share2 – Share1
-///
-/// Where Share1 is a randomly chosen aligned value, and Share2 is the sum of
-/// Share1 and the actual callee address.
-bool IndirectCall::process(Function &F, const DataLayout &DL,
-                           LLVMContext &Ctx) {
-  Module &M = *F.getParent();
-  auto *IntPtrTy = DL.getIntPtrType(Ctx);
-  SmallVector<Constant *, 32> Shares1, Shares2;
-  SmallVector<CallInst *, 32> DirectCalls;
-
-  // Gather direct function calls, candidates to be converted to indirect ones.
+// Gather direct function calls, candidates to be converted to indirect ones.
+static void collectDirectCalls(Function &F,
+                               SmallVectorImpl<CallInst *> &DirectCalls) {
   for (Instruction &I : instructions(F)) {
     auto *CI = dyn_cast<CallInst>(&I);
     if (!CI)
@@ -49,6 +41,18 @@ bool IndirectCall::process(Function &F, const DataLayout &DL,
         Callee->hasFnAttribute(Attribute::AlwaysInline))
       continue;
 
+    DirectCalls.push_back(CI);
+  }
+}
+
+/// Materialize the shares of every distinct callee of the module into two
+/// constant global arrays, shared by all the rewritten call-sites.
+void IndirectCall::createShareTables(Module &M, ArrayRef<Function *> Callees) {
+  const auto &DL = M.getDataLayout();
+  auto *IntPtrTy = DL.getIntPtrType(M.getContext());
+  SmallVector<Constant *, 32> Shares1, Shares2;
+
+  for (Function *Callee : Callees) {
     Constant *TargetAddr = ConstantExpr::getPtrToInt(Callee, IntPtrTy);
     APInt RandomVal(IntPtrTy->getBitWidth(), getRandomShareAligned());
     Constant *Share1 = ConstantInt::get(IntPtrTy, RandomVal);
@@ -56,29 +60,40 @@ bool IndirectCall::process(Function &F, const DataLayout &DL,
 
     Shares1.push_back(Share1);
     Shares2.push_back(Share2);
-    DirectCalls.push_back(CI);
   }
 
-  if (DirectCalls.empty())
-    return false;
-
-  // Materialize all the shares into two constant global arrays.
   ArrayType *ArrTy = ArrayType::get(IntPtrTy, Shares1.size());
-  auto *GVAddrShares1 =
+  GVAddrShares1 =
       new GlobalVariable(M, ArrTy, true, GlobalValue::InternalLinkage,
                          ConstantArray::get(ArrTy, Shares1), ".icall.shares1");
-  auto *GVAddrShares2 =
+  GVAddrShares2 =
       new GlobalVariable(M, ArrTy, true, GlobalValue::InternalLinkage,
                          ConstantArray::get(ArrTy, Shares2), ".icall.shares2");
+}
 
+/// This pass rewrites direct calls into an indirect call through an address
+/// reconstructed given two random shares:
+///
+///   Address = Share2 – Share1
+///
+/// Where Share1 is a randomly chosen aligned value, and Share2 is the sum of
+/// Share1 and the actual callee address.
+bool IndirectCall::process(Function &F, const DataLayout &DL,
+                           LLVMContext &Ctx, ArrayRef<CallInst *> DirectCalls,
+                           const IndirectCallConfig &Opt) {
+  if (DirectCalls.empty())
+    return false;
+
+  auto *IntPtrTy = DL.getIntPtrType(Ctx);
+  ArrayType *ArrTy = cast<ArrayType>(GVAddrShares1->getValueType());
   IRBuilder<> Builder(Ctx);
   auto *Zero = ConstantInt::get(Type::getInt64Ty(Ctx), 0);
 
-  // Rewrite each call-site by loading the shares and computing the final
-  // target address as the difference between Share2 and Share1.
-  for (auto [Idx, CI] : enumerate(DirectCalls)) {
-    Builder.SetInsertPoint(CI);
-    Constant *Index = ConstantInt::get(Type::getInt64Ty(Ctx), Idx);
+  auto MaterializeAddress = [&](Instruction *InsertPt,
+                                Function *Callee) -> Value * {
+    Builder.SetInsertPoint(InsertPt);
+    Constant *Index =
+        ConstantInt::get(Type::getInt64Ty(Ctx), CalleeToIdx.lookup(Callee));
 
     Value *PtrS1 =
         Builder.CreateInBoundsGEP(ArrTy, GVAddrShares1, {Zero, Index});
@@ -91,27 +106,46 @@ bool IndirectCall::process(Function &F, const DataLayout &DL,
     Value *Share2 = Builder.CreateLoad(IntPtrTy, PtrS2, /* isVolatile */ true);
 
     Value *Address = Builder.CreateSub(Share2, Share1);
-    SDEBUG("[{}] Rewriting call-site: {}", name(), ToString(*CI));
+    return Builder.CreateIntToPtr(Address, Builder.getPtrTy(0));
+  };
+
+  // The callee address is loop-invariant: optionally compute it once in the
+  // preheader of the outermost loop containing the call-site.
+  std::optional<DominatorTree> DT;
+  std::optional<LoopInfo> LI;
+  if (Opt.HoistFromLoops) {
+    DT.emplace(F);
+    LI.emplace(*DT);
+  }
+  DenseMap<std::pair<BasicBlock *, Function *>, Value *> HoistedAddresses;
+
+  // Rewrite each call-site by loading the shares and computing the final
+  // target address as the difference between Share2 and Share1.
+  for (CallInst *CI : DirectCalls) {
+    Function *Callee = CI->getCalledFunction();
+
+    BasicBlock *Preheader = nullptr;
+    if (LI)
+      if (Loop *L = LI->getLoopFor(CI->getParent()))
+        Preheader = L->getOutermostLoop()->getLoopPreheader();
 
     // Reconstruct the callee address.
-    CI->setCalledOperand(Builder.CreateIntToPtr(Address, Builder.getPtrTy(0)));
+    if (Preheader) {
+      Value *&Address = HoistedAddresses[{Preheader, Callee}];
+      if (!Address)
+        Address = MaterializeAddress(Preheader->getTerminator(), Callee);
+      CI->setCalledOperand(Address);
+    } else {
+      CI->setCalledOperand(MaterializeAddress(CI, Callee));
+    }
   }
 
   return true;
 }
 
-PreservedAnalyses IndirectCall::run(Module &M, ModuleAnalysisManager &MAM) {
-  if (isModuleGloballyExcluded(&M)) {
-    SINFO("Excluding module [{}]", M.getName());
-    return PreservedAnalyses::all();
-  }
-
-  bool Changed = false;
+bool IndirectCall::beginModule(Module &M) {
   PyConfig &Config = PyConfig::instance();
-  LLVMContext &Ctx = M.getContext();
-  const auto &DL = M.getDataLayout();
-  SINFO("[{}] Executing on module {}", name(), M.getName());
-
+  SmallVector<Function *, 32> Callees;
   for (Function &F : M) {
     IndirectCallOpt Opt = Config.getUserConfig()->indirectCall(&M, &F);
     if (!Opt || !*Opt)
@@ -121,9 +155,56 @@ PreservedAnalyses IndirectCall::run(Module &M, ModuleAnalysisManager &MAM) {
         F.isIntrinsic() || F.getName().starts_with("__omvll"))
       continue;
 
-    Changed |= process(F, DL, Ctx);
+    FunctionCallSites &Sites =
+        CallSites.try_emplace(&F, FunctionCallSites{*Opt, {}}).first->second;
+    collectDirectCalls(F, Sites.DirectCalls);
+
+    // One pair of shares per distinct callee, rather than per call-site.
+    for (CallInst *CI : Sites.DirectCalls) {
+      Function *Callee = CI->getCalledFunction();
+      if (CalleeToIdx.try_emplace(Callee, Callees.size()).second)
+        Callees.push_back(Callee);
+    }
+  }
+
+  if (Callees.empty())
+    return false;
+
+  createShareTables(M, Callees);
+  return true;
+}
+
+bool IndirectCall::visitFunction(Function &F) {
+  auto It = CallSites.find(&F);
+  if (It == CallSites.end() || !GVAddrShares1)
+    return false;
+
+  RandomGenerator::FunctionStream Stream(F);
+  return process(F, F.getParent()->getDataLayout(), F.getContext(),
+                 It->second.DirectCalls, It->second.Opt);
+}
+
+bool IndirectCall::endModule(Module &) {
+  CallSites.clear();
+  CalleeToIdx.clear();
+  GVAddrShares1 = GVAddrShares2 = nullptr;
+  return false;
+}
+
+PreservedAnalyses IndirectCall::run(Module &M, ModuleAnalysisManager &MAM) {
+  if (isModuleGloballyExcluded(&M)) {
+    SINFO("Excluding module [{}]", M.getName());
+    return PreservedAnalyses::all();
   }
 
+  bool Changed = false;
+  SINFO("[{}] Executing on module {}", name(), M.getName());
+
+  Changed |= beginModule(M);
+  for (Function &F : M)
+    Changed |= visitFunction(F);
+  Changed |= endModule(M);
+
   SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
         M.getName());
 
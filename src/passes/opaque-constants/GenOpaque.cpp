@@ -4,6 +4,8 @@
 //
 
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/NoFolder.h"
 #include "llvm/Support/RandomNumberGenerator.h"
@@ -23,12 +25,49 @@ static Value *attachMDOpaqueCst(Value *I) {
   return I;
 }
 
+static Value *getSeed(IRBuilder<NoFolder> &IRB, AllocaInst *T, Value *S,
+                      Type *Ty) {
+  if (S)
+    return IRB.CreateZExtOrTrunc(S, Ty);
+  return IRB.CreateLoad(Ty, T, true);
+}
+
+// Constants of an identity must not reach the optimizer as such: it would
+// combine them (e.g., (S * A) * A^-1 into S * 1) and undo the identity. Reload
+// C from a volatile stack slot or, with register seeds, pass it through an
+// empty inline asm.
+static Value *getOpaqueOperand(IRBuilder<NoFolder> &IRB, OpaqueContext &Ctx,
+                               AllocaInst *T, Constant *C) {
+  Type *Ty = C->getType();
+  if (Ctx.S1) {
+    auto *AsmTy = FunctionType::get(Ty, {Ty}, false);
+    InlineAsm *Opaque =
+        InlineAsm::get(AsmTy, "", "=r,0", /* hasSideEffects */ false);
+    return IRB.CreateCall(AsmTy, Opaque, {C});
+  }
+
+  IRB.CreateStore(C, T, true);
+  return IRB.CreateLoad(Ty, T, true);
+}
+
+// Random odd A and its inverse modulo 2^BitWidth (Ty must fit in 64 bits).
+static std::pair<Constant *, Constant *>
+getMultiplicativeInversePair(Type *Ty) {
+  uint64_t A = RandomGenerator::generateFullRand() | 1;
+  // Newton's iteration doubles the number of correct low bits at each step,
+  // starting from 3 correct bits for X = A.
+  uint64_t AInv = A;
+  for (unsigned Step = 0; Step < 5; ++Step)
+    AInv *= 2 - A * AInv;
+  return {ConstantInt::get(Ty, A), ConstantInt::get(Ty, AInv)};
+}
+
 /* ========= Zero Value Gen ========= */
 Value *getOpaqueZero1(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
   IRBuilder<NoFolder> IRB(&I);
 
-  Value *Seed1 = IRB.CreateLoad(Ty, Ctx.T1, true);
-  Value *Seed2 = IRB.CreateLoad(Ty, Ctx.T2, true);
+  Value *Seed1 = getSeed(IRB, Ctx.T1, Ctx.S1, Ty);
+  Value *Seed2 = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
 
   Value *Masked = attachMDOpaqueCst(IRB.CreateXor(Seed1, Seed2));
   Value *X = attachMDOpaqueCst(IRB.CreateXor(Masked, Seed1));
@@ -43,11 +82,28 @@ Value *getOpaqueZero1(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
 }
 
 Value *getOpaqueZero2(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
-  return getOpaqueZero1(I, Ctx, Ty);
+  IRBuilder<NoFolder> IRB(&I);
+
+  // S * (S + 1) is even: (S * (S + 1)) & 1 == 0
+  Value *Seed = getSeed(IRB, Ctx.T1, Ctx.S1, Ty);
+  Value *Next = attachMDOpaqueCst(IRB.CreateAdd(Seed, ConstantInt::get(Ty, 1)));
+  Value *Even = attachMDOpaqueCst(IRB.CreateMul(Seed, Next));
+  return attachMDOpaqueCst(IRB.CreateAnd(Even, ConstantInt::get(Ty, 1)));
 }
 
 Value *getOpaqueZero3(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
-  return getOpaqueZero1(I, Ctx, Ty);
+  if (Ty->getIntegerBitWidth() > 64)
+    return nullptr;
+
+  IRBuilder<NoFolder> IRB(&I);
+  auto [A, AInv] = getMultiplicativeInversePair(Ty);
+
+  // (S * A) * A^-1 == S: ((S * A) * A^-1) ^ S == 0
+  Value *Seed = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
+  Value *Mul = attachMDOpaqueCst(IRB.CreateMul(Seed, A));
+  Value *Inv = attachMDOpaqueCst(
+      IRB.CreateMul(Mul, getOpaqueOperand(IRB, Ctx, Ctx.T1, AInv)));
+  return attachMDOpaqueCst(IRB.CreateXor(Inv, Seed));
 }
 
 /* ========= One Value Gen ========= */
@@ -58,7 +114,7 @@ Value *getOpaqueOne1(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
   if (N % 2 == 0)
     N++; // Ensure odd
 
-  Value *Seed = IRB.CreateLoad(Ty, Ctx.T2, true);
+  Value *Seed = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
   Value *Masked =
       attachMDOpaqueCst(IRB.CreateXor(ConstantInt::get(Ty, N), Seed));
   Value *Even = attachMDOpaqueCst(IRB.CreateXor(Masked, Seed));
@@ -71,11 +127,30 @@ Value *getOpaqueOne1(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
 }
 
 Value *getOpaqueOne2(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
-  return getOpaqueOne1(I, Ctx, Ty);
+  IRBuilder<NoFolder> IRB(&I);
+
+  // ((S * (S + 1)) & 1) ^ 1 == 1
+  Value *Seed = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
+  Value *Next = attachMDOpaqueCst(IRB.CreateAdd(Seed, ConstantInt::get(Ty, 1)));
+  Value *Even = attachMDOpaqueCst(IRB.CreateMul(Seed, Next));
+  Value *Zero = attachMDOpaqueCst(IRB.CreateAnd(Even, ConstantInt::get(Ty, 1)));
+  return attachMDOpaqueCst(IRB.CreateXor(Zero, ConstantInt::get(Ty, 1)));
 }
 
 Value *getOpaqueOne3(Instruction &I, OpaqueContext &Ctx, Type *Ty) {
-  return getOpaqueOne1(I, Ctx, Ty);
+  IRBuilder<NoFolder> IRB(&I);
+  const unsigned BitWidth = Ty->getIntegerBitWidth();
+
+  // popcount(S) + popcount(~S) == BitWidth
+  Value *Seed = getSeed(IRB, Ctx.T1, Ctx.S1, Ty);
+  Value *NotSeed = attachMDOpaqueCst(IRB.CreateNot(Seed));
+  Value *Pop = attachMDOpaqueCst(
+      IRB.CreateUnaryIntrinsic(Intrinsic::ctpop, Seed));
+  Value *NotPop = attachMDOpaqueCst(
+      IRB.CreateUnaryIntrinsic(Intrinsic::ctpop, NotSeed));
+  Value *Sum = attachMDOpaqueCst(IRB.CreateAdd(Pop, NotPop));
+  return attachMDOpaqueCst(
+      IRB.CreateSub(Sum, ConstantInt::get(Ty, BitWidth - 1)));
 }
 
 /* ========= Value != {0, 1} Gen ========= */
@@ -91,8 +166,8 @@ Value *getOpaqueConst1(Instruction &I, OpaqueContext &Ctx,
   Type *Ty = CI.getType();
   IRBuilder<NoFolder> IRB(&I);
 
-  Value *V1 = IRB.CreateLoad(Ty, Ctx.T1, true);
-  Value *V2 = IRB.CreateLoad(Ty, Ctx.T2, true);
+  Value *V1 = getSeed(IRB, Ctx.T1, Ctx.S1, Ty);
+  Value *V2 = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
 
   Value *Xor1 = attachMDOpaqueCst(IRB.CreateXor(V1, V2));
   Value *Xor2 = attachMDOpaqueCst(IRB.CreateXor(V2, V1));
@@ -103,6 +178,10 @@ Value *getOpaqueConst1(Instruction &I, OpaqueContext &Ctx,
   Value *OpaqueRHS = attachMDOpaqueCst(
       IRB.CreateAdd(OpaqueZero, ConstantInt::get(Ty, RHS, false)));
 
+  // Without stack slots, directly combine both halves.
+  if (Ctx.S1)
+    return attachMDOpaqueCst(IRB.CreateAdd(OpaqueLHS, OpaqueRHS));
+
   IRB.CreateStore(OpaqueLHS, Ctx.T2, true);
   IRB.CreateStore(OpaqueRHS, Ctx.T1, true);
 
@@ -113,12 +192,52 @@ Value *getOpaqueConst1(Instruction &I, OpaqueContext &Ctx,
 
 Value *getOpaqueConst2(Instruction &I, OpaqueContext &Ctx,
                        const ConstantInt &CI) {
-  return getOpaqueConst1(I, Ctx, CI);
+  Type *Ty = CI.getType();
+  if (Ty->getIntegerBitWidth() > 64)
+    return nullptr;
+
+  uint64_t Val = CI.getLimitedValue();
+  uint64_t Mask = RandomGenerator::generateFullRand();
+  auto [A, AInv] = getMultiplicativeInversePair(Ty);
+  IRBuilder<NoFolder> IRB(&I);
+
+  // (((S ^ M) * A) * A^-1) ^ S == M: M ^ (Val ^ M) == Val
+  Value *Seed = getSeed(IRB, Ctx.T1, Ctx.S1, Ty);
+  Value *Masked =
+      attachMDOpaqueCst(IRB.CreateXor(Seed, ConstantInt::get(Ty, Mask)));
+  Value *Mul = attachMDOpaqueCst(IRB.CreateMul(Masked, A));
+  Value *Inv = attachMDOpaqueCst(
+      IRB.CreateMul(Mul, getOpaqueOperand(IRB, Ctx, Ctx.T2, AInv)));
+  Value *Unseeded = attachMDOpaqueCst(IRB.CreateXor(Inv, Seed));
+  return attachMDOpaqueCst(
+      IRB.CreateXor(Unseeded, ConstantInt::get(Ty, Val ^ Mask)));
 }
 
 Value *getOpaqueConst3(Instruction &I, OpaqueContext &Ctx,
                        const ConstantInt &CI) {
-  return getOpaqueConst1(I, Ctx, CI);
+  uint64_t Val = CI.getLimitedValue();
+  if (Val <= 1 || Val == std::numeric_limits<uint64_t>::max())
+    return nullptr;
+
+  Type *Ty = CI.getType();
+  if (Ty->getIntegerBitWidth() > 64)
+    return nullptr;
+
+  uint64_t RHS = RandomGenerator::generateRange(1, Val - 1);
+  uint64_t LHS = Val - RHS;
+  IRBuilder<NoFolder> IRB(&I);
+
+  // LHS + ((S * (S + 1)) & 1) + RHS == Val, with RHS out of reach of the
+  // reassociation of both additions.
+  Value *Seed = getSeed(IRB, Ctx.T2, Ctx.S2, Ty);
+  Value *Next = attachMDOpaqueCst(IRB.CreateAdd(Seed, ConstantInt::get(Ty, 1)));
+  Value *Even = attachMDOpaqueCst(IRB.CreateMul(Seed, Next));
+  Value *Zero = attachMDOpaqueCst(IRB.CreateAnd(Even, ConstantInt::get(Ty, 1)));
+  Value *OpaqueLHS =
+      attachMDOpaqueCst(IRB.CreateAdd(Zero, ConstantInt::get(Ty, LHS, false)));
+  Value *OpaqueRHS =
+      getOpaqueOperand(IRB, Ctx, Ctx.T1, ConstantInt::get(Ty, RHS, false));
+  return attachMDOpaqueCst(IRB.CreateAdd(OpaqueLHS, OpaqueRHS));
 }
 
 } // end namespace omvll
@@ -19,7 +19,24 @@ namespace omvll {
 
 struct OpaqueContext;
 
-// Opaque Zero generator.
+// Estimated cycles of a reload of a stack seed (or constant).
+static constexpr unsigned OpaqueSeedLoadCost = 4;
+
+// Generator tagged with an estimate of the cycles it adds at runtime: simple
+// ALU operations count for 1, multiplications for 3 and popcounts for 4, on
+// top of the seeds and constants reloaded from the stack (if any).
+template <typename FnTy> struct OpaqueGenerator {
+  FnTy *Fn;
+  unsigned Cost;
+  unsigned SeedLoads;
+
+  constexpr unsigned getCost(bool RegisterSeeds) const {
+    return Cost + (RegisterSeeds ? 0 : SeedLoads * OpaqueSeedLoadCost);
+  }
+};
+
+// Opaque Zero generators: XOR identities (1), parity of S * (S + 1) (2),
+// multiplicative inverses (3).
 llvm::Value *getOpaqueZero1(llvm::Instruction &I, OpaqueContext &Ctx,
                             llvm::Type *Ty);
 llvm::Value *getOpaqueZero2(llvm::Instruction &I, OpaqueContext &Ctx,
@@ -27,7 +44,8 @@ llvm::Value *getOpaqueZero2(llvm::Instruction &I, OpaqueContext &Ctx,
 llvm::Value *getOpaqueZero3(llvm::Instruction &I, OpaqueContext &Ctx,
                             llvm::Type *Ty);
 
-// Opaque One generator.
+// Opaque One generators: XOR identities (1), parity of S * (S + 1) (2),
+// bit-count of S and ~S (3).
 llvm::Value *getOpaqueOne1(llvm::Instruction &I, OpaqueContext &Ctx,
                            llvm::Type *Ty);
 llvm::Value *getOpaqueOne2(llvm::Instruction &I, OpaqueContext &Ctx,
@@ -35,7 +53,8 @@ llvm::Value *getOpaqueOne2(llvm::Instruction &I, OpaqueContext &Ctx,
 llvm::Value *getOpaqueOne3(llvm::Instruction &I, OpaqueContext &Ctx,
                            llvm::Type *Ty);
 
-// Opaque Value != {0, 1} generator.
+// Opaque Value != {0, 1} generators: XOR identities (1), multiplicative
+// inverses (2), parity of S * (S + 1) (3).
 llvm::Value *getOpaqueConst1(llvm::Instruction &I, OpaqueContext &Ctx,
                              const llvm::ConstantInt &Val);
 llvm::Value *getOpaqueConst2(llvm::Instruction &I, OpaqueContext &Ctx,
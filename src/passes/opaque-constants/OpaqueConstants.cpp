@@ -5,8 +5,11 @@
 
 #include <utility>
 
+#include "llvm/Analysis/LoopInfo.h"
 #include "llvm/IR/Constants.h"
+#include "llvm/IR/Dominators.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InlineAsm.h"
 #include "llvm/IR/InstVisitor.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/NoFolder.h"
@@ -35,8 +38,59 @@ inline bool isSkip(const OpaqueConstantsOpt &Opt) {
   return std::get_if<OpaqueConstantsSkip>(&Opt) != nullptr;
 }
 
+static const OpaqueConstantsTuning *getTuning(const OpaqueConstantsOpt &Opt) {
+  return std::visit(
+      overloaded{
+          [](const OpaqueConstantsSkip &) -> const OpaqueConstantsTuning * {
+            return nullptr;
+          },
+          [](const OpaqueConstantsTuning &V) -> const OpaqueConstantsTuning * {
+            return &V;
+          },
+      },
+      Opt);
+}
+
+// Parameters recorded in the stamp of an obfuscated function.
+static std::string getStampParams(const OpaqueConstantsOpt &Opt) {
+  std::string Params;
+  raw_string_ostream OS(Params);
+  auto PrintValues = [&](const DenseSet<uint64_t> &Values) {
+    SmallVector<uint64_t, 8> Sorted(Values.begin(), Values.end());
+    llvm::sort(Sorted);
+    interleave(Sorted, OS, ";");
+  };
+
+  std::visit(overloaded{
+                 [](const OpaqueConstantsSkip &) {},
+                 [&](const OpaqueConstantsBool &V) {
+                   OS << "value=" << V.Value;
+                 },
+                 [&](const OpaqueConstantsLowerLimit &V) {
+                   OS << "lower_limit=" << V.Value;
+                 },
+                 [&](const OpaqueConstantsSet &V) {
+                   OS << "set=";
+                   PrintValues(V.Values);
+                 },
+                 [&](const OpaqueConstantsExcludeSet &V) {
+                   OS << "exclude=";
+                   PrintValues(V.Values);
+                 },
+             },
+             Opt);
+
+  if (const OpaqueConstantsTuning *Tuning = getTuning(Opt))
+    OS << ",rounds=" << unsigned(Tuning->ArithRounds)
+       << ",register_seeds=" << Tuning->RegisterSeeds
+       << ",latency_budget=" << Tuning->LatencyBudget
+       << ",reuse_factor=" << Tuning->ReuseFactor
+       << ",hoist_from_loops=" << Tuning->HoistFromLoops;
+  return OS.str();
+}
+
 bool OpaqueConstants::process(Instruction &I, Use &Op, ConstantInt &CI,
-                              OpaqueConstantsOpt *Opt) {
+                              OpaqueConstantsOpt *Opt, Instruction *InsertPt) {
   if (!isEligible(I))
     return false;
 
@@ -89,22 +143,36 @@ bool OpaqueConstants::process(Instruction &I, Use &Op, ConstantInt &CI,
   if (Opt && !ShouldProtect(CI))
     return false;
 
+  Instruction &At = InsertPt ? *InsertPt : I;
+
+  // Reuse the expression materialized for a previous use in the same block.
+  // As the pass walks the block forward, it dominates I.
+  std::pair<Value *, uint32_t> *Shared = nullptr;
+  if (Ctx->ReuseFactor > 1) {
+    Shared = &Ctx->Shared[{At.getParent(), &CI}];
+    if (Shared->first && Shared->second > 0) {
+      --Shared->second;
+      Op.set(Shared->first);
+      return true;
+    }
+  }
+
   Value *NewVal = nullptr;
 
   if (CI.isZero()) {
     // Special processing for 0 values.
-    NewVal = getOpaqueZero(I, *Ctx, CI.getType());
+    NewVal = getOpaqueZero(At, *Ctx, CI.getType());
     #ifdef OMVLL_DEBUG
       SDEBUG("[{}][{}] Opaquized", name(), CI.getLimitedValue());
     #endif
   } else if (CI.isOne()) {
     // Special processing for 1 values.
-    NewVal = getOpaqueOne(I, *Ctx, CI.getType());
+    NewVal = getOpaqueOne(At, *Ctx, CI.getType());
     #ifdef OMVLL_DEBUG
       SDEBUG("[{}][{}] Opaquized", name(), CI.getLimitedValue());
     #endif
   } else {
-    NewVal = getOpaqueCst(I, *Ctx, CI);
+    NewVal = getOpaqueCst(At, *Ctx, CI);
     #ifdef OMVLL_DEBUG
       SDEBUG("[{}][{}] Opaquized", name(), CI.getLimitedValue());
     #endif
@@ -115,44 +183,96 @@ bool OpaqueConstants::process(Instruction &I, Use &Op, ConstantInt &CI,
     return false;
   }
 
+  if (Shared)
+    *Shared = {NewVal, Ctx->ReuseFactor - 1};
+
   Op.set(NewVal);
   return true;
 }
 
-template <typename CasesT, typename... ArgsT>
-static Value *getOpaqueRandomRoutine(const CasesT &Cases, ArgsT &&...Args) {
+template <typename FnTy, size_t N, typename... ArgsT>
+static Value *
+getOpaqueRandomRoutine(const std::array<OpaqueGenerator<FnTy>, N> &Cases,
+                       OpaqueContext &Ctx, ArgsT &&...Args) {
   static constexpr auto MaxCases = 3;
-  static_assert(std::numeric_limits<uint64_t>::max() >= MaxCases);
+  static_assert(N == MaxCases);
   const auto Idx = RandomGenerator::generateRange(0, MaxCases - 1);
   assert(Idx < Cases.size() && "Shouldn't have Idx out of bounds?");
 
-  if (Value *V = (*Cases[Idx])(std::forward<ArgsT>(Args)...))
-    return V;
+  // Without a budget, all the generators are drawn from. With a budget, only
+  // the affordable ones are.
+  const bool RegisterSeeds = Ctx.S1 != nullptr;
+  SmallVector<const OpaqueGenerator<FnTy> *, MaxCases> Candidates;
+  for (const OpaqueGenerator<FnTy> &Gen : Cases)
+    if (!Ctx.LatencyBudget ||
+        Gen.getCost(RegisterSeeds) <= *Ctx.LatencyBudget)
+      Candidates.push_back(&Gen);
+
+  // Start from the drawn generator, falling back on the next candidates if it
+  // does not support the value.
+  for (size_t I = 0; I < Candidates.size(); ++I) {
+    const OpaqueGenerator<FnTy> &Gen =
+        *Candidates[(Idx + I) % Candidates.size()];
+    if (Value *V = (*Gen.Fn)(Args...)) {
+      if (Ctx.LatencyBudget)
+        *Ctx.LatencyBudget -= Gen.getCost(RegisterSeeds);
+      return V;
+    }
+  }
+
+  if (!Ctx.LatencyBudget)
+    return nullptr;
+
+  // Once the budget is spent, the constants still get the cheapest generator
+  // that supports them.
+  SmallVector<const OpaqueGenerator<FnTy> *, MaxCases> ByCost;
+  for (const OpaqueGenerator<FnTy> &Gen : Cases)
+    ByCost.push_back(&Gen);
+  llvm::stable_sort(ByCost, [&](const auto *LHS, const auto *RHS) {
+    return LHS->getCost(RegisterSeeds) < RHS->getCost(RegisterSeeds);
+  });
+
+  for (const OpaqueGenerator<FnTy> *Gen : ByCost) {
+    if (Value *V = (*Gen->Fn)(Args...)) {
+      *Ctx.LatencyBudget = 0;
+      return V;
+    }
+  }
   return nullptr;
 }
 
 Value *OpaqueConstants::getOpaqueZero(Instruction &I, OpaqueContext &Ctx,
                                       Type *Ty) {
-  static constexpr std::array Cases{&getOpaqueZero1, &getOpaqueZero2,
-                                    &getOpaqueZero3};
-  return getOpaqueRandomRoutine(Cases, I, Ctx, Ty);
+  // The stack version of getOpaqueZero3 reloads a constant of its identity.
+  using GenTy = OpaqueGenerator<decltype(getOpaqueZero1)>;
+  static constexpr std::array Cases{GenTy{&getOpaqueZero1, 6, 2},
+                                    GenTy{&getOpaqueZero2, 5, 1},
+                                    GenTy{&getOpaqueZero3, 7, 2}};
+  return getOpaqueRandomRoutine(Cases, Ctx, I, Ctx, Ty);
 }
 
 Value *OpaqueConstants::getOpaqueOne(Instruction &I, OpaqueContext &Ctx,
                                      Type *Ty) {
-  static constexpr std::array Cases{&getOpaqueOne1, &getOpaqueOne2,
-                                    &getOpaqueOne3};
-  return getOpaqueRandomRoutine(Cases, I, Ctx, Ty);
+  using GenTy = OpaqueGenerator<decltype(getOpaqueOne1)>;
+  static constexpr std::array Cases{GenTy{&getOpaqueOne1, 4, 1},
+                                    GenTy{&getOpaqueOne2, 6, 1},
+                                    GenTy{&getOpaqueOne3, 11, 1}};
+  return getOpaqueRandomRoutine(Cases, Ctx, I, Ctx, Ty);
 }
 
 Value *OpaqueConstants::getOpaqueCst(Instruction &I, OpaqueContext &Ctx,
                                      const ConstantInt &CI) {
-  static constexpr std::array Cases{&getOpaqueConst1, &getOpaqueConst2,
-                                    &getOpaqueConst3};
-  return getOpaqueRandomRoutine(Cases, I, Ctx, CI);
+  // The stack version of getOpaqueConst1 reloads both halves of the value, the
+  // ones of getOpaqueConst2 and getOpaqueConst3 a constant of their identity.
+  using GenTy = OpaqueGenerator<decltype(getOpaqueConst1)>;
+  static constexpr std::array Cases{GenTy{&getOpaqueConst1, 6, 4},
+                                    GenTy{&getOpaqueConst2, 9, 2},
+                                    GenTy{&getOpaqueConst3, 7, 2}};
+  return getOpaqueRandomRoutine(Cases, Ctx, I, Ctx, CI);
 }
 
-bool OpaqueConstants::process(Instruction &I, OpaqueConstantsOpt *Opt) {
+bool OpaqueConstants::process(Instruction &I, OpaqueConstantsOpt *Opt,
+                              Instruction *InsertPt) {
   bool Changed = false;
 
 #ifdef OMVLL_DEBUG
@@ -160,7 +280,7 @@ bool OpaqueConstants::process(Instruction &I, OpaqueConstantsOpt *Opt) {
 #endif
   for (Use &Op : I.operands())
     if (auto *CI = dyn_cast<ConstantInt>(Op))
-      Changed |= process(I, Op, *CI, Opt);
+      Changed |= process(I, Op, *CI, Opt, InsertPt);
 
 #ifdef OMVLL_DEBUG
   if (Changed)
@@ -187,6 +307,33 @@ OpaqueContext *OpaqueConstants::getOrCreateContext(Function &F) {
     }
   }
 
+  const OpaqueConstantsTuning *Tuning = nullptr;
+  if (auto It = Opts.find(&F); It != Opts.end())
+    Tuning = getTuning(It->second);
+  if (Tuning && Tuning->LatencyBudget > 0)
+    Ctx.LatencyBudget = Tuning->LatencyBudget;
+  if (Tuning)
+    Ctx.ReuseFactor = Tuning->ReuseFactor;
+
+  if (Tuning && Tuning->RegisterSeeds) {
+    // An empty inline asm returning its operand cannot be folded by the
+    // optimizer, yet lowers to nothing: the seeds can stay in registers
+    // instead of being reloaded from the stack at every use.
+    Type *IntPtrTy = DL.getIntPtrType(F.getContext());
+    auto *AsmTy = FunctionType::get(IntPtrTy, {IntPtrTy}, false);
+    InlineAsm *Opaque =
+        InlineAsm::get(AsmTy, "", "=r,0", /* hasSideEffects */ false);
+    Ctx.S1 = IRB.CreateCall(
+        AsmTy, Opaque,
+        {ConstantInt::get(IntPtrTy, RandomGenerator::generateFullRand())},
+        "opaque.s1");
+    Ctx.S2 = IRB.CreateCall(
+        AsmTy, Opaque,
+        {ConstantInt::get(IntPtrTy, RandomGenerator::generateFullRand())},
+        "opaque.s2");
+    return &Ctx;
+  }
+
   Ctx.T1 = IRB.CreateAlloca(IRB.getInt64Ty(), nullptr, "opaque.t1");
   Ctx.T2 = IRB.CreateAlloca(IRB.getInt64Ty(), nullptr, "opaque.t2");
 
@@ -199,68 +346,109 @@ OpaqueContext *OpaqueConstants::getOrCreateContext(Function &F) {
 }
 
 bool OpaqueConstants::runOnBasicBlock(llvm::BasicBlock &BB,
-                                      OpaqueConstantsOpt *Opt) {
+                                      OpaqueConstantsOpt *Opt,
+                                      Instruction *InsertPt) {
   bool Changed = false;
 
   for (Instruction &I : BB) {
     if (hasObf(I, MetaObfTy::OpaqueCst)) {
       OpaqueConstantsOpt Force = OpaqueConstantsBool(true);
-      Changed |= process(I, &Force);
+      Changed |= process(I, &Force, InsertPt);
     } else if (Opt) {
-      Changed |= process(I, Opt);
+      Changed |= process(I, Opt, InsertPt);
     }
   }
 
   return Changed;
 }
 
-PreservedAnalyses OpaqueConstants::run(Module &M, ModuleAnalysisManager &FAM) {
-  bool Changed = false;
-  if (isModuleGloballyExcluded(&M)) {
-    SINFO("Excluding module [{}]", M.getName());
-    return PreservedAnalyses::all();
-  }
+static bool isCandidate(Function &F) {
+  return !isFunctionGloballyExcluded(&F) && !F.isDeclaration() &&
+         !F.isIntrinsic() && !F.getName().starts_with("__omvll");
+}
+
+void OpaqueConstants::queryConfig(ObfuscationConfig &UserConfig,
+                                  Function &F) {
+  if (isCandidate(F))
+    UserConfig.obfuscateConstants(F.getParent(), &F);
+}
+
+bool OpaqueConstants::visitFunction(Function &F) {
+  if (!isCandidate(F))
+    return false;
 
   PyConfig &Config = PyConfig::instance();
-  SINFO("[{}] Executing on module {}", name(), M.getName());
+  OpaqueConstantsOpt Opt =
+      Config.getUserConfig()->obfuscateConstants(F.getParent(), &F);
+  OpaqueConstantsOpt *Inserted = nullptr;
+  if (isSkip(Opt))
+    return false;
 
-  for (Function &F : M) {
-    bool ChangedFunction = false;
-    if (isFunctionGloballyExcluded(&F) || F.isDeclaration() ||
-        F.isIntrinsic() || F.getName().starts_with("__omvll"))
-      continue;
+  std::string Params = getStampParams(Opt);
+  if (isAlreadyObfuscated(F, name(), Params))
+    return false;
+
+  auto Ret = Opts.insert({&F, std::move(Opt)});
+  if (Ret.second)
+    Inserted = &Ret.first->second;
+
+  RandomGenerator::FunctionStream Stream(F);
 
-    OpaqueConstantsOpt Opt = Config.getUserConfig()->obfuscateConstants(&M, &F);
-    OpaqueConstantsOpt *Inserted = nullptr;
-    if (isSkip(Opt))
+  // Opaque constants of loops are computed once, in the preheader of the
+  // outermost loop. The CFG is left untouched, so LoopInfo stays valid.
+  std::optional<DominatorTree> DT;
+  std::optional<LoopInfo> LI;
+  const OpaqueConstantsTuning *Tuning = getTuning(Ret.first->second);
+  if (Tuning && Tuning->HoistFromLoops) {
+    DT.emplace(F);
+    LI.emplace(*DT);
+  }
+
+  // Loop blocks come last so that the expressions hoisted into preheaders
+  // are not processed again.
+  bool Changed = false;
+  SmallVector<std::pair<BasicBlock *, Instruction *>, 8> LoopBlocks;
+  for (BasicBlock &BB : F) {
+    // Don't try opaque constants when potentially handling infinite loops.
+    if (is_contained(successors(&BB), &BB))
       continue;
 
-    auto Ret = Opts.insert({&F, std::move(Opt)});
-    if (Ret.second)
-      Inserted = &Ret.first->second;
+    BasicBlock *Preheader = nullptr;
+    if (LI)
+      if (Loop *L = LI->getLoopFor(&BB))
+        Preheader = L->getOutermostLoop()->getLoopPreheader();
 
-    for (BasicBlock &BB : F) {
-      // Don't try opaque constants when potentially handling infinite loops.
-      if (is_contained(successors(&BB), &BB))
-        continue;
-      ChangedFunction |= runOnBasicBlock(BB, Inserted);
-    }
-    Changed |= ChangedFunction;
-
-    if (ChangedFunction && Inserted) {
-      size_t ArithRounds = std::visit(overloaded{
-          [](OpaqueConstantsSkip &)          -> size_t { return 0; },
-          [](OpaqueConstantsBool &V)         -> size_t { return V.ArithRounds; },
-          [](OpaqueConstantsLowerLimit &V)   -> size_t { return V.ArithRounds; },
-          [](OpaqueConstantsSet &V)          -> size_t { return V.ArithRounds; },
-          [](OpaqueConstantsExcludeSet &V)    -> size_t { return V.ArithRounds; },
-      }, *Inserted);
-      if (ArithRounds > 0)
-        Arith.runOnFunction(F, ArithRounds);
-    }
+    if (Preheader)
+      LoopBlocks.push_back({&BB, Preheader->getTerminator()});
+    else
+      Changed |= runOnBasicBlock(BB, Inserted);
+  }
+
+  for (auto [BB, InsertPt] : LoopBlocks)
+    Changed |= runOnBasicBlock(*BB, Inserted, InsertPt);
 
+  if (Changed && Inserted && Tuning && Tuning->ArithRounds > 0)
+    Arith.runOnFunction(F, Tuning->ArithRounds);
+
+  if (Changed)
+    addPassStamp(F, name(), Params);
+  return Changed;
+}
+
+PreservedAnalyses OpaqueConstants::run(Module &M, ModuleAnalysisManager &FAM) {
+  bool Changed = false;
+  if (isModuleGloballyExcluded(&M)) {
+    SINFO("Excluding module [{}]", M.getName());
+    return PreservedAnalyses::all();
   }
 
+  SINFO("[{}] Executing on module {}", name(), M.getName());
+
+  Changed |= beginModule(M);
+  for (Function &F : M)
+    Changed |= visitFunction(F);
+  Changed |= endModule(M);
+
   SINFO("[{}] Changes {} applied on module {}", name(), Changed ? "" : "not",
         M.getName());
 
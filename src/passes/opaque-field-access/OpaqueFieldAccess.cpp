@@ -22,11 +22,33 @@ using namespace llvm;
 
 namespace omvll {
 
+bool OpaqueFieldAccess::shouldObfuscateStruct(Function &F, StructType &S) {
+  // JNI-heavy code accesses the same structures (e.g. _JNIEnv) thousands of
+  // times: only ask the user once per function.
+  auto [It, Inserted] = StructDecisions.try_emplace({&F, &S}, false);
+  if (Inserted) {
+    PyConfig &Config = PyConfig::instance();
+    It->second =
+        Config.getUserConfig()->obfuscateStructAccess(F.getParent(), &F, &S);
+  }
+  return It->second;
+}
+
+uint64_t OpaqueFieldAccess::getFieldOffset(const DataLayout &DL, StructType &S,
+                                           uint64_t Idx) {
+  SmallVector<uint64_t, 8> &Offsets = FieldOffsets[&S];
+  if (Offsets.empty()) {
+    const StructLayout *Layout = DL.getStructLayout(&S);
+    for (unsigned I = 0, E = S.getNumElements(); I < E; ++I)
+      Offsets.push_back(Layout->getElementOffset(I));
+  }
+  assert(Idx < Offsets.size() && "Field index out of bounds");
+  return Offsets[Idx];
+}
+
 bool OpaqueFieldAccess::runOnStructRead(BasicBlock &BB, LoadInst &Load,
                                         GetElementPtrInst &GEP, StructType &S) {
-  PyConfig &Config = PyConfig::instance();
-  if (!Config.getUserConfig()->obfuscateStructAccess(BB.getModule(),
-                                                     BB.getParent(), &S))
+  if (!shouldObfuscateStruct(*BB.getParent(), S))
     return false;
 
   SINFO("[{}] Executing on module {} over structure {}", name(),
@@ -48,8 +70,8 @@ bool OpaqueFieldAccess::runOnStructRead(BasicBlock &BB, LoadInst &Load,
     SWARN("[{}] Expecting a zero value for the getelementptr: {}", name(),
           ToString(GEP));
 
-  const DataLayout &DL = BB.getParent()->getParent()->getDataLayout();
-  uint64_t ComputedOffset = DL.getStructLayout(&S)->getElementOffset(OffVal->getLimitedValue());
+  const DataLayout &DL = BB.getModule()->getDataLayout();
+  uint64_t ComputedOffset = getFieldOffset(DL, S, OffVal->getLimitedValue());
 
   SDEBUG("[{}] Obfuscating field READ access on {}->#{} (offset: {})", name(),
          S.getName(), OffVal->getLimitedValue(), ComputedOffset);
@@ -226,9 +248,7 @@ bool OpaqueFieldAccess::runOnConstantExprWrite(BasicBlock &BB, StoreInst &Store,
 bool OpaqueFieldAccess::runOnStructWrite(BasicBlock &BB, StoreInst &Store,
                                          GetElementPtrInst &GEP,
                                          StructType &S) {
-  PyConfig &Config = PyConfig::instance();
-  if (!Config.getUserConfig()->obfuscateStructAccess(BB.getModule(),
-                                                     BB.getParent(), &S))
+  if (!shouldObfuscateStruct(*BB.getParent(), S))
     return false;
 
   SINFO("[{}] Executing on module {} over structure {}", name(),
@@ -250,8 +270,8 @@ bool OpaqueFieldAccess::runOnStructWrite(BasicBlock &BB, StoreInst &Store,
     SWARN("[{}] Expecting a zero value for the getelementptr {}", name(),
           ToString(GEP));
 
-  const DataLayout &DL = BB.getParent()->getParent()->getDataLayout();
-  uint64_t ComputedOffset = DL.getStructLayout(&S)->getElementOffset(OffVal->getLimitedValue());
+  const DataLayout &DL = BB.getModule()->getDataLayout();
+  uint64_t ComputedOffset = getFieldOffset(DL, S, OffVal->getLimitedValue());
 
   SDEBUG("[{}] Obfuscating field WRITE access on {}->#{} (offset: {})", name(),
          S.getName(), OffVal->getLimitedValue(), ComputedOffset);
@@ -368,6 +388,9 @@ PreservedAnalyses OpaqueFieldAccess::run(Module &M,
     return PreservedAnalyses::all();
   }
 
+  StructDecisions.clear();
+  FieldOffsets.clear();
+
   bool Changed = false;
   for (Function &F : M) {
     if (isFunctionGloballyExcluded(&F))
@@ -0,0 +1,20 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+import omvll
+from functools import lru_cache
+
+class MyConfig(omvll.ObfuscationConfig):
+    # Only the module guard must stop the second run.
+    omvll.config.skip_obfuscated_functions = False
+
+    def __init__(self):
+        super().__init__()
+    def obfuscate_arithmetic(self, mod: omvll.Module,
+                                   fun: omvll.Function) -> omvll.ArithmeticOpt:
+        return omvll.ArithmeticOpt(rounds=1)
+
+@lru_cache(maxsize=1)
+def omvll_get_config() -> omvll.ObfuscationConfig:
+    return MyConfig()
@@ -0,0 +1,24 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+import os
+import omvll
+from functools import lru_cache
+
+class MyConfig(omvll.ObfuscationConfig):
+    omvll.config.output_folder = os.environ["OMVLL_OUTPUT_FOLDER"]
+    omvll.config.per_function_seeds = True
+    omvll.config.incremental_cache = True
+
+    def __init__(self):
+        super().__init__()
+    def obfuscate_constants(self, mod: omvll.Module, func: omvll.Function):
+        return True
+    def obfuscate_arithmetic(self, mod: omvll.Module,
+                                   fun: omvll.Function) -> omvll.ArithmeticOpt:
+        return omvll.ArithmeticOpt(rounds=1)
+
+@lru_cache(maxsize=1)
+def omvll_get_config() -> omvll.ObfuscationConfig:
+    return MyConfig()
@@ -0,0 +1,54 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// With per-function seeds, running OpaqueConstants and Arithmetic on worker
+// threads gives the same output as running them on the current thread.
+
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_unfused.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.unfused.ll
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_function_pass_threads.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.threads.ll
+// RUN: diff %t.unfused.ll %t.threads.ll
+// RUN: FileCheck %s < %t.threads.ll
+
+// The functions that cannot be copied to a worker thread (@dispatch, which
+// takes the address of its blocks, and every function with -g) go through the
+// run on the current thread that follows the workers, like the functions of a
+// shard that cannot be spliced back.
+
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_unfused.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -g -S -emit-llvm %s -o %t.unfused.g.ll
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_function_pass_threads.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -g -S -emit-llvm %s -o %t.threads.g.ll
+// RUN: diff %t.unfused.g.ll %t.threads.g.ll
+
+// CHECK-LABEL: define {{.*}} @mix(
+// CHECK:         load volatile
+// CHECK-LABEL: define {{.*}} @sum(
+// CHECK:         load volatile
+// CHECK-LABEL: define {{.*}} @caller(
+// CHECK-NOT:     call {{.*}} @mix(
+// CHECK:         ret
+// CHECK-LABEL: define {{.*}} @dispatch(
+// CHECK:         load volatile
+
+struct pair {
+  int a, b;
+};
+
+static int counter;
+
+int mix(int x, int y) { return (x ^ y) + 3; }
+
+int sum(struct pair *p) { return p->a + p->b + counter++; }
+
+int caller(int x) { return mix(x, 7) ^ mix(7, x); }
+
+int dispatch(int op, int x) {
+  static void *ops[] = {&&add, &&sub};
+  goto *ops[op & 1];
+add:
+  return x + 5;
+sub:
+  return x - 5;
+}
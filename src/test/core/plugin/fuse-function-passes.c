@@ -0,0 +1,24 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// With per-function seeds, running the function-local passes in a single walk
+// gives the same output as running them one after the other.
+
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_unfused.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.unfused.ll
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_fused.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.fused.ll
+// RUN: diff %t.unfused.ll %t.fused.ll
+// RUN: FileCheck %s < %t.fused.ll
+
+// CHECK-LABEL: define {{.*}} @mix(
+// CHECK:         load volatile
+// CHECK-LABEL: define {{.*}} @caller(
+// CHECK-NOT:     call {{.*}} @mix(
+// CHECK:         ret
+
+int mix(int x, int y) { return (x ^ y) + 3; }
+
+int caller(int x) { return mix(x, 7) ^ mix(7, x); }
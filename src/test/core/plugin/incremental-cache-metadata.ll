@@ -0,0 +1,29 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target
+
+; The key of a cached function covers the content of its metadata: editing a
+; !range node misses the cache instead of reusing the previous body.
+
+; RUN: rm -rf %t.dir
+; RUN: env OMVLL_OUTPUT_FOLDER=%t.dir OMVLL_CONFIG=%S/Inputs/config_incremental_cache.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.first.ll
+; RUN: sed 's/i32 0, i32 10}/i32 0, i32 20}/' %s > %t.edited.ll
+; RUN: env OMVLL_OUTPUT_FOLDER=%t.dir OMVLL_CONFIG=%S/Inputs/config_incremental_cache.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %t.edited.ll -o %t.second.ll
+; RUN: FileCheck %s < %t.second.ll
+; RUN: ls %t.dir/cache/functions | FileCheck --check-prefix=ENTRIES %s
+
+; ENTRIES-COUNT-2: {{^[0-9a-f]+}}.bc
+
+; CHECK-LABEL: define {{.*}} @bounded(
+; CHECK:         load i32, ptr %p, align 4, !range ![[RANGE:[0-9]+]]
+; CHECK:       ![[RANGE]] = !{i32 0, i32 20}
+
+define i32 @bounded(ptr %p, i32 %x) {
+  %v = load i32, ptr %p, align 4, !range !0
+  %r = xor i32 %v, %x
+  ret i32 %r
+}
+
+!0 = !{i32 0, i32 10}
@@ -0,0 +1,32 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// Only the functions referring to globals that existed before the passes are
+// cached: the ones rewritten by IndirectCall or IndirectBranch refer to their
+// tables and are not. A single entry is expected, for @mix.
+
+// RUN: rm -rf %t.dir
+// RUN: env OMVLL_OUTPUT_FOLDER=%t.dir OMVLL_CONFIG=%S/Inputs/config_incremental_cache_passes.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.ll
+// RUN: clang -target aarch64-linux-android -S -emit-llvm -x ir %t.dir/cache/functions/*.bc -o - | FileCheck %s
+
+// CHECK:     define {{.*}} @mix(
+// CHECK-NOT: define {{.*}} @caller(
+// CHECK-NOT: define {{.*}} @pick(
+
+int mix(int a, int b) {
+  return (a ^ b) * 3;
+}
+
+int caller(int x) {
+  return mix(x, 42);
+}
+
+int pick(int x) {
+  if (x > 3)
+    return x * 2;
+  return x + 1;
+}
@@ -0,0 +1,31 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// The second build reuses the functions cached by the first one, and gives
+// the same output.
+
+// RUN: rm -rf %t.dir
+// RUN: env OMVLL_OUTPUT_FOLDER=%t.dir OMVLL_CONFIG=%S/Inputs/config_incremental_cache.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.cold.ll
+// RUN: ls %t.dir/cache/functions | FileCheck --check-prefix=ENTRIES %s
+// RUN: env OMVLL_OUTPUT_FOLDER=%t.dir OMVLL_CONFIG=%S/Inputs/config_incremental_cache.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.warm.ll
+// RUN: diff %t.cold.ll %t.warm.ll
+// RUN: FileCheck %s < %t.warm.ll
+
+// ENTRIES-COUNT-2: {{^[0-9a-f]+}}.bc
+
+// CHECK-LABEL: define {{.*}} @mix(
+// CHECK:         load volatile
+// CHECK-LABEL: define {{.*}} @caller(
+// CHECK:         ret
+
+int mix(int a, int b) {
+  return (a ^ b) + 0x1234;
+}
+
+int caller(int x) {
+  return mix(x, 42) * 3;
+}
@@ -0,0 +1,26 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// A module records the phases it was obfuscated in, and is not obfuscated
+// again when it goes through a second pipeline (e.g. a ThinLTO backend).
+
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_arithmetic.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.first.ll
+// RUN: env OMVLL_CONFIG=%S/Inputs/config_arithmetic.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm -x ir %t.first.ll -o %t.second.ll
+// RUN: FileCheck %s < %t.first.ll
+// RUN: sed 1d %t.first.ll > %t.first.body
+// RUN: sed 1d %t.second.ll > %t.second.body
+// RUN: diff %t.first.body %t.second.body
+
+// CHECK-LABEL: define {{.*}} @mix(
+// CHECK:         and i32
+// CHECK:         ret
+// CHECK:       !omvll.obfuscated = !{![[EARLY:[0-9]+]]}
+// CHECK:       ![[EARLY]] = !{!"early"}
+
+int mix(int a, int b) {
+  return a ^ b;
+}
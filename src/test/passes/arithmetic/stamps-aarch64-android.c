@@ -0,0 +1,43 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target
+
+// A function obfuscated in the early phase is stamped, and the last phase
+// does not obfuscate it again with the same parameters.
+
+// RUN: env OMVLL_CONFIG=%S/config_both_phases.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.both.ll
+// RUN: FileCheck %s < %t.both.ll
+
+// The body is the one of a run in the early phase only (metadata numbers
+// aside), and differs from it when the stamps are ignored.
+
+// RUN: env OMVLL_CONFIG=%S/config_rounds_1.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.early.ll
+// RUN: env OMVLL_CONFIG=%S/config_both_phases_noskip.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.noskip.ll
+// RUN: sed -n '/^define.*@mix(/,/^}/p' %t.both.ll | sed -E 's/![0-9]+/!N/g' > %t.both.body
+// RUN: sed -n '/^define.*@mix(/,/^}/p' %t.early.ll | sed -E 's/![0-9]+/!N/g' > %t.early.body
+// RUN: sed -n '/^define.*@mix(/,/^}/p' %t.noskip.ll | sed -E 's/![0-9]+/!N/g' > %t.noskip.body
+// RUN: diff %t.early.body %t.both.body
+// RUN: not diff %t.early.body %t.noskip.body
+
+// CHECK-LABEL: define {{.*}} @mix({{.*}} !omvll.passes ![[STAMPS:[0-9]+]]
+// CHECK:       ![[STAMPS]] = !{![[ARITH:[0-9]+]]}
+// CHECK:       ![[ARITH]] = !{!"omvll::Arithmetic", !"rounds=1"}
+
+// BreakControlFlow stamps both the trampoline and the protected body, which the
+// last phase then leaves alone.
+
+// RUN: env OMVLL_CONFIG=%S/config_both_phases_break_cfg.py clang -target aarch64-linux-android -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o - | FileCheck --check-prefix=BREAK %s
+
+// BREAK-LABEL: define {{.*}} @mix({{.*}} !omvll.passes ![[STAMPS:[0-9]+]]
+// BREAK-NOT:   define
+// BREAK-LABEL: define internal {{.*}} @mix.1({{.*}} !omvll.passes ![[STAMPS]]
+// BREAK-NOT:   define
+// BREAK:       ![[STAMPS]] = !{![[BREAK:[0-9]+]]}
+// BREAK:       ![[BREAK]] = !{!"omvll::BreakControlFlow", !"splice_body=0,tail_call=0"}
+
+int mix(int a, int b) {
+  return a ^ b;
+}
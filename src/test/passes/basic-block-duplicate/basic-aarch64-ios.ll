@@ -7,24 +7,28 @@
 ; RUN: env OMVLL_CONFIG=%S/config_all.py clang++ -fpass-plugin=%libOMVLL \
 ; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck --check-prefixes=CHECK %s
 
+; CHECK-NOT: lrand48
+; CHECK-NOT: global i64
+
 define i32 @dup(i32 %arg) {
 ; CHECK-LABEL: define i32 @dup(
 ; CHECK-SAME: i32 [[ARG:%.*]])
 ; CHECK-NEXT:  [[ENTRY:.*:]]
+; CHECK-NEXT:    [[SLOT:%.*]] = alloca i8, align 1
 ; CHECK-NEXT:    br label %[[BB:.*]]
 ; CHECK:       [[BB]]:
-; CHECK-NEXT:    [[CALL1:%.*]] = call i64 @lrand48()
-; CHECK-NEXT:    [[AND1:%.*]] = and i64 [[CALL1]], 1
-; CHECK-NEXT:    [[CMP1:%.*]] = icmp ne i64 [[AND1]], 0
+; CHECK-NEXT:    [[ADDR1:%.*]] = ptrtoint ptr [[SLOT]] to i64
+; CHECK-NEXT:    [[MIX1:%.*]] = mul i64 [[ADDR1]], {{-?[0-9]+}}
+; CHECK-NEXT:    [[CMP1:%.*]] = icmp slt i64 [[MIX1]], 0
 ; CHECK-NEXT:    br i1 [[CMP1]], label %[[BB_SPLIT_CLONE:.*]], label %[[BB_SPLIT:.*]]
 ; CHECK:       [[BB_SPLIT]]:
 ; CHECK-NEXT:    [[X:%.*]] = add i32 [[ARG]], 2
 ; CHECK-NEXT:    br label %[[EXIT:.*]]
 ; CHECK:       [[EXIT]]:
 ; CHECK-NEXT:    [[X1:%.*]] = phi i32 [ [[X_CLONE:%.*]], %[[BB_SPLIT_CLONE]] ], [ [[X:%.*]], %[[BB_SPLIT]] ]
-; CHECK-NEXT:    [[CALL2:%.*]] = call i64 @lrand48()
-; CHECK-NEXT:    [[AND2:%.*]] = and i64 [[CALL2]], 1
-; CHECK-NEXT:    [[CMP2:%.*]] = icmp ne i64 [[AND2]], 0
+; CHECK-NEXT:    [[ADDR2:%.*]] = ptrtoint ptr [[SLOT]] to i64
+; CHECK-NEXT:    [[MIX2:%.*]] = mul i64 [[ADDR2]], {{-?[0-9]+}}
+; CHECK-NEXT:    [[CMP2:%.*]] = icmp slt i64 [[MIX2]], 0
 ; CHECK-NEXT:    br i1 [[CMP2]], label %[[EXIT_SPLIT_CLONE:.*]], label %[[EXIT_SPLIT:.*]]
 ; CHECK:       [[EXIT_SPLIT]]:
 ; CHECK-NEXT:    [[Y:%.*]] = add i32 [[X1]], 1
@@ -0,0 +1,16 @@
+#
+# This file is distributed under the Apache License v2.0. See LICENSE for details.
+#
+
+import omvll
+from functools import lru_cache
+
+class MyConfig(omvll.ObfuscationConfig):
+    def __init__(self):
+        super().__init__()
+    def break_control_flow(self, mod: omvll.Module, func: omvll.Function):
+        return omvll.BreakControlFlowOpt(True, tail_call=True)
+
+@lru_cache(maxsize=1)
+def omvll_get_config() -> omvll.ObfuscationConfig:
+    return MyConfig()
@@ -0,0 +1,50 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_tail_call.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; Even at -O0, the trampoline jumps to the protected function rather than calling it.
+define i32 @check(ptr %passwd, i32 %len) {
+; CHECK-LABEL: define i32 @check(
+; CHECK:         [[ADDR:%.*]] = load volatile i64
+; CHECK-NEXT:    [[FPTR:%.*]] = inttoptr i64 [[ADDR]] to ptr
+; CHECK-NEXT:    [[CALL:%.*]] = musttail call i32 [[FPTR]](ptr %passwd, i32 %len)
+; CHECK-NEXT:    ret i32 [[CALL]]
+; CHECK-LABEL: define internal i32 @check.1(
+entry:
+  %cmp = icmp eq i32 %len, 5
+  %res = zext i1 %cmp to i32
+  ret i32 %res
+}
+
+%struct.S = type { i64, i64, i64 }
+
+; An sret argument may be passed in the register the trampoline jumps through:
+; the call is only hinted as a tail call.
+define void @make(ptr sret(%struct.S) align 8 %out, i64 %val) {
+; CHECK-LABEL: define void @make(
+; CHECK:         [[FPTR:%.*]] = inttoptr i64 {{%.*}} to ptr
+; CHECK-NEXT:    tail call void [[FPTR]](ptr sret(%struct.S) align 8 %out, i64 %val)
+; CHECK-NEXT:    ret void
+; CHECK-LABEL: define internal void @make.1(
+entry:
+  store i64 %val, ptr %out, align 8
+  ret void
+}
+
+; Neither is the byval copy, which lives in the frame of the caller, forwarded
+; through a musttail call.
+define i64 @first(ptr byval(%struct.S) align 8 %s) {
+; CHECK-LABEL: define i64 @first(
+; CHECK:         [[FPTR:%.*]] = inttoptr i64 {{%.*}} to ptr
+; CHECK-NEXT:    [[CALL:%.*]] = tail call i64 [[FPTR]](ptr byval(%struct.S) align 8 %s)
+; CHECK-NEXT:    ret i64 [[CALL]]
+; CHECK-LABEL: define internal i64 @first.1(
+entry:
+  %val = load i64, ptr %s, align 8
+  ret i64 %val
+}
@@ -0,0 +1,43 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_grow.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck --check-prefixes=CHECK %s
+
+; The diamond a -> {l, r} is outlined as a single SESE region, as it has fewer
+; inputs and outputs than outlining each of its blocks separately.
+define i32 @grow_regions(i32 %x, i32 %y) {
+; CHECK-LABEL: define i32 @grow_regions(
+; CHECK:         call {{.*}} @grow_regions.a(
+; CHECK-NOT:     call {{.*}} @grow_regions.l(
+; CHECK-NOT:     call {{.*}} @grow_regions.r(
+; CHECK:       define internal {{.*}} @grow_regions.a(
+; CHECK:       a:
+; CHECK:       l:
+; CHECK:       r:
+entry:
+  br label %a
+
+a:
+  %a1 = add i32 %x, 1
+  %a2 = mul i32 %a1, %x
+  %c = icmp sgt i32 %a2, 10
+  br i1 %c, label %l, label %r
+
+l:
+  %l1 = mul i32 %a2, 3
+  %l2 = xor i32 %l1, 5
+  br label %m
+
+r:
+  %r1 = sub i32 %a2, 7
+  %r2 = shl i32 %r1, 2
+  br label %m
+
+m:
+  %res = phi i32 [ %l2, %l ], [ %r2, %r ]
+  ret i32 %res
+}
@@ -0,0 +1,80 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_skip_hot.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck --check-prefixes=CHECK %s
+
+; The loop body is hot and must not be outlined, while the cold exit block is.
+define i32 @hot_loop(i32 %n, i32 %y) {
+; CHECK-LABEL: define i32 @hot_loop(
+; CHECK:       loop:
+; CHECK-NEXT:    %i = phi i32
+; CHECK-NEXT:    %acc = phi i32
+; CHECK-NEXT:    %mul = mul i32 %acc, %y
+; CHECK-NEXT:    %add = add i32 %mul, %i
+; CHECK-NEXT:    %inc = add i32 %i, 1
+; CHECK-NEXT:    %cmp = icmp slt i32 %inc, %n
+; CHECK-NEXT:    br i1 %cmp, label %loop, label %{{.*}}
+; CHECK:         call void @hot_loop.exit(
+; CHECK-NOT:   define internal void @hot_loop.loop(
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %acc = phi i32 [ 1, %entry ], [ %add, %loop ]
+  %mul = mul i32 %acc, %y
+  %add = add i32 %mul, %i
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  %r1 = mul i32 %add, 3
+  %r2 = xor i32 %r1, %y
+  %r3 = sub i32 %r2, %n
+  br label %end
+
+end:
+  ret i32 %r3
+}
+
+; The error path of the loop is cold, and outlined despite its loop depth.
+define i32 @cold_path_in_loop(i32 %n, i32 %y) {
+; CHECK-LABEL: define i32 @cold_path_in_loop(
+; CHECK:         call void @cold_path_in_loop.error(
+; CHECK-NOT:   define internal void @cold_path_in_loop.latch(
+; CHECK:       define internal void @cold_path_in_loop.error(
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %latch ]
+  %acc = phi i32 [ 1, %entry ], [ %next, %latch ]
+  %bad = icmp eq i32 %acc, 0
+  br i1 %bad, label %error, label %latch, !prof !0
+
+error:
+  %e1 = mul i32 %i, 7
+  %e2 = xor i32 %e1, %y
+  %e3 = add i32 %e2, %n
+  store volatile i32 %e3, ptr @last_error
+  br label %latch
+
+latch:
+  %mul = mul i32 %acc, %y
+  %next = add i32 %mul, %i
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %end
+
+end:
+  ret i32 %next
+}
+
+@last_error = global i32 0
+
+!0 = !{!"branch_weights", i32 1, i32 100000}
@@ -9,6 +9,11 @@
 
 ; CHECK: @[[INDIRECT_BLOCKADDR:[a-zA-Z0-9_$"\\.-]+]] = private constant [3 x ptr] {{.*}}, section "__DATA,__const"
 ; CHECK: @[[INDIRECT_BLOCKADDR2:[a-zA-Z0-9_$"\\.-]+]] = private constant [4 x ptr] {{.*}}, section "__DATA,__const"
+; CHECK: @[[SWITCH_INDEX:[a-zA-Z0-9_$"\\.-]+]] = private constant [3 x i8]
+; CHECK: @[[INDIRECT_BLOCKADDR3:[a-zA-Z0-9_$"\\.-]+]] = private constant [5 x ptr] {{.*}}, section "__DATA,__const"
+; CHECK: @[[SWITCH_DISP:[a-zA-Z0-9_$"\\.-]+]] = private constant [4 x i8]
+; CHECK: @[[SWITCH_KEYS:[a-zA-Z0-9_$"\\.-]+]] = private constant [8 x i32]
+; CHECK: @[[SWITCH_SLOTS:[a-zA-Z0-9_$"\\.-]+]] = private constant [8 x i8]
 
 define i32 @simple_branch(i32 %arg) {
 ; CHECK-LABEL:  define i32 @simple_branch(
@@ -36,14 +41,18 @@ false:
 define i32 @simple_switch(i32 %arg) {
 ; CHECK-LABEL:  define i32 @simple_switch(
 ; CHECK-LABEL:  entry
-; CHECK:          [[COND:%.*]] = icmp eq i32 %arg, 1
-; CHECK-NEXT:     [[SEL1:%.*]] = select i1 [[COND:%.*]], ptr {{.*}}, ptr {{.*}}
-; CHECK-NEXT:     [[COND1:%.*]] = icmp eq i32 %arg, 2
-; CHECK-NEXT:     [[SEL2:%.*]] = select i1 [[COND1:%.*]], ptr {{.*}}, ptr [[SEL1:%.*]]
-; CHECK-NEXT:     [[COND2:%.*]] = icmp eq i32 %arg, 3
-; CHECK-NEXT:     [[SEL3:%.*]] = select i1 [[COND2:%.*]], ptr {{.*}}, ptr [[SEL2:%.*]]
-; CHECK-NEXT:     [[LD2:%.*]] = load ptr, ptr [[SEL3:%.*]], align 8
-; CHECK-NEXT:     indirectbr ptr [[LD2:%.*]], [label %default, label %case1, label %case2, label %case3]
+; CHECK:          [[OFF:%.*]] = sub i32 %arg, 1
+; CHECK-NEXT:     [[INRANGE:%.*]] = icmp ule i32 [[OFF]], 2
+; CHECK-NEXT:     [[CLAMPED:%.*]] = select i1 [[INRANGE]], i32 [[OFF]], i32 0
+; CHECK-NEXT:     [[IDX:%.*]] = zext i32 [[CLAMPED]] to i64
+; CHECK-NEXT:     [[ENTRY:%.*]] = getelementptr inbounds [3 x i8], ptr @[[SWITCH_INDEX]], i64 0, i64 [[IDX]]
+; CHECK-NEXT:     [[ENC:%.*]] = load i8, ptr [[ENTRY]], align 1
+; CHECK-NEXT:     [[DEC:%.*]] = xor i8 [[ENC]], {{-?[0-9]+}}
+; CHECK-NEXT:     [[SLOT:%.*]] = zext i8 [[DEC]] to i64
+; CHECK-NEXT:     [[SEL:%.*]] = select i1 [[INRANGE]], i64 [[SLOT]], i64 {{[0-9]+}}
+; CHECK-NEXT:     [[GEP:%.*]] = getelementptr inbounds [4 x ptr], ptr @[[INDIRECT_BLOCKADDR2]], i64 0, i64 [[SEL]]
+; CHECK-NEXT:     [[LD2:%.*]] = load ptr, ptr [[GEP]], align 8
+; CHECK-NEXT:     indirectbr ptr [[LD2]], [label %default, label %case1, label %case2, label %case3]
 entry:
   %add = add i32 %arg, 1
   switch i32 %arg, label %default [
@@ -64,3 +73,51 @@ case3:
 default:
   ret i32 %add
 }
+
+define i32 @sparse_switch(i32 %arg) {
+; CHECK-LABEL:  define i32 @sparse_switch(
+; CHECK-LABEL:  entry
+; CHECK:          [[KEY:%.*]] = zext i32 %arg to i64
+; CHECK-NEXT:     [[MUL1:%.*]] = mul i64 [[KEY]], {{-?[0-9]+}}
+; CHECK-NEXT:     [[BUCKET:%.*]] = lshr i64 [[MUL1]], 62
+; CHECK-NEXT:     [[DISPPTR:%.*]] = getelementptr inbounds [4 x i8], ptr @[[SWITCH_DISP]], i64 0, i64 [[BUCKET]]
+; CHECK-NEXT:     [[DISP:%.*]] = load i8, ptr [[DISPPTR]], align 1
+; CHECK-NEXT:     [[DISP64:%.*]] = zext i8 [[DISP]] to i64
+; CHECK-NEXT:     [[MUL2:%.*]] = mul i64 [[KEY]], {{-?[0-9]+}}
+; CHECK-NEXT:     [[HASH:%.*]] = lshr i64 [[MUL2]], 61
+; CHECK-NEXT:     [[POS:%.*]] = xor i64 [[HASH]], [[DISP64]]
+; CHECK-NEXT:     [[KEYPTR:%.*]] = getelementptr inbounds [8 x i32], ptr @[[SWITCH_KEYS]], i64 0, i64 [[POS]]
+; CHECK-NEXT:     [[CASEKEY:%.*]] = load i32, ptr [[KEYPTR]], align 4
+; CHECK-NEXT:     [[MATCH:%.*]] = icmp eq i32 [[CASEKEY]], %arg
+; CHECK-NEXT:     [[SLOTPTR:%.*]] = getelementptr inbounds [8 x i8], ptr @[[SWITCH_SLOTS]], i64 0, i64 [[POS]]
+; CHECK-NEXT:     [[ENC:%.*]] = load i8, ptr [[SLOTPTR]], align 1
+; CHECK-NEXT:     [[DEC:%.*]] = xor i8 [[ENC]], {{-?[0-9]+}}
+; CHECK-NEXT:     [[SLOT:%.*]] = zext i8 [[DEC]] to i64
+; CHECK-NEXT:     [[SEL:%.*]] = select i1 [[MATCH]], i64 [[SLOT]], i64 {{[0-9]+}}
+; CHECK-NEXT:     [[GEP:%.*]] = getelementptr inbounds [5 x ptr], ptr @[[INDIRECT_BLOCKADDR3]], i64 0, i64 [[SEL]]
+; CHECK-NEXT:     [[LD:%.*]] = load ptr, ptr [[GEP]], align 8
+; CHECK-NEXT:     indirectbr ptr [[LD]], [label %default, label %case1, label %case2, label %case3, label %case4]
+entry:
+  %add = add i32 %arg, 1
+  switch i32 %arg, label %default [
+    i32 7, label %case1
+    i32 1000, label %case2
+    i32 123456, label %case3
+    i32 -42, label %case4
+  ]
+
+case1:
+  ret i32 0
+
+case2:
+  ret i32 1
+
+case3:
+  ret i32 2
+
+case4:
+  ret i32 3
+
+default:
+  ret i32 %add
+}
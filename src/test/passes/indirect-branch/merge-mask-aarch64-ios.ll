@@ -0,0 +1,55 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_merge_mask.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; CHECK-NOT: @indbr.masked_block_addresses
+; CHECK:     @indbr.merged_masked_block_addresses = private constant [5 x i64] [i64 add (i64 ptrtoint (ptr blockaddress(@{{simple_branch|other_branch}}, {{.*}}) to i64), i64 {{[0-9]+}}), {{.*}}], section "__DATA,__const", align 8
+; CHECK-NOT: @indbr.masked_block_addresses
+
+define i32 @simple_branch(i32 %arg) {
+; CHECK-LABEL:  define i32 @simple_branch(
+; CHECK-LABEL:  if:
+; CHECK:          [[SEL:%.*]] = select i1 %cmp, ptr {{.*}}@indbr.merged_masked_block_addresses{{.*}}, ptr {{.*}}@indbr.merged_masked_block_addresses
+; CHECK-NEXT:     [[LD:%.*]] = load i64, ptr [[SEL]], align 8
+; CHECK-NEXT:     [[SUB:%.*]] = sub i64 [[LD]], {{[0-9]+}}
+; CHECK-NEXT:     [[TARGET:%.*]] = inttoptr i64 [[SUB]] to ptr
+; CHECK-NEXT:     indirectbr ptr [[TARGET]], [label %true, label %false]
+entry:
+  %add = add i32 %arg, 1
+  br label %if
+
+if:
+  %cmp = icmp eq i32 %arg, 0
+  br i1 %cmp, label %true, label %false
+
+true:
+  ret i32 %add
+
+false:
+  ret i32 1
+}
+
+define i32 @other_branch(i32 %arg) {
+; CHECK-LABEL:  define i32 @other_branch(
+; CHECK-LABEL:  entry:
+; CHECK:          [[SEL:%.*]] = select i1 %cmp, ptr {{.*}}@indbr.merged_masked_block_addresses{{.*}}, ptr {{.*}}@indbr.merged_masked_block_addresses
+; CHECK-NEXT:     [[LD:%.*]] = load i64, ptr [[SEL]], align 8
+; CHECK-NEXT:     [[SUB:%.*]] = sub i64 [[LD]], {{[0-9]+}}
+; CHECK-NEXT:     [[TARGET:%.*]] = inttoptr i64 [[SUB]] to ptr
+; CHECK-NEXT:     indirectbr ptr [[TARGET]], [label %true, label %false]
+entry:
+  %add = mul i32 %arg, 3
+  %cmp = icmp sgt i32 %arg, 7
+  br i1 %cmp, label %true, label %false
+
+true:
+  ret i32 %add
+
+false:
+  ret i32 0
+}
@@ -0,0 +1,57 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_hoist.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; Shares are emitted once per distinct callee across the whole module.
+; CHECK: @[[ICALL_SHARES1:.*]] = internal constant [2 x i64] [i64 {{.*}}, i64 {{.*}}]
+; CHECK: @[[ICALL_SHARES2:.*]] = internal constant [2 x i64] [i64 add (i64 ptrtoint (ptr @foo to i64), i64 {{.*}}), i64 add (i64 ptrtoint (ptr @qux to i64), i64 {{.*}})]
+
+define void @loop_calls(i32 %n) {
+; CHECK-LABEL:  define void @loop_calls(
+; CHECK-LABEL:  preheader:
+; CHECK:          [[LD1:%.*]] = load volatile i64, ptr @[[ICALL_SHARES1]], align 8
+; CHECK-NEXT:     [[LD2:%.*]] = load volatile i64, ptr @[[ICALL_SHARES2]], align 8
+; CHECK-NEXT:     [[SUB:%.*]] = sub i64 [[LD2]], [[LD1]]
+; CHECK-NEXT:     [[FOO:%.*]] = inttoptr i64 [[SUB]] to ptr
+; CHECK-NEXT:     br label %loop
+; CHECK-LABEL:  loop:
+; CHECK-NOT:      load volatile
+; CHECK:          call void [[FOO]]()
+; CHECK-NEXT:     call void [[FOO]]()
+; CHECK-LABEL:  exit:
+; CHECK:          load volatile i64, ptr getelementptr inbounds ([2 x i64], ptr @[[ICALL_SHARES1]], i64 0, i64 1), align 8
+entry:
+  br label %preheader
+
+preheader:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %preheader ], [ %inc, %loop ]
+  call void @foo()
+  call void @foo()
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  call void @qux()
+  ret void
+}
+
+define void @other_calls() {
+; CHECK-LABEL:  define void @other_calls(
+; CHECK:          load volatile i64, ptr @[[ICALL_SHARES1]], align 8
+; CHECK-NEXT:     load volatile i64, ptr @[[ICALL_SHARES2]], align 8
+entry:
+  call void @foo()
+  ret void
+}
+
+declare void @foo()
+declare void @qux()
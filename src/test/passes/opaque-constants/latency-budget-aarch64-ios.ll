@@ -0,0 +1,30 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_latency_budget.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; With register seeds, a budget of 4 cycles affords none of the opaque zero
+; generators: the cheapest one protects the constant all the same and spends
+; the budget. The other constants then get the cheapest generators.
+define i32 @opaque_constants(ptr %p) {
+; CHECK-LABEL:  define i32 @opaque_constants(
+; CHECK:          [[EVEN:%.+]] = mul i32 {{%.+}}, {{%.+}}, !obf
+; CHECK-NEXT:     [[ZERO:%.+]] = and i32 [[EVEN]], 1, !obf
+; CHECK-NEXT:     store i32 [[ZERO]], ptr %p, align 4
+; CHECK:          [[ONE:%.+]] = and i32 {{%.+}}, 1, !obf
+; CHECK-NEXT:     store i32 [[ONE]], ptr %p, align 4
+; CHECK:          [[CST:%.+]] = add i32 {{%.+}}, {{%.+}}, !obf
+; CHECK-NEXT:     %sum = add i32 [[CST]], %val
+; CHECK-NOT:      ctpop
+; CHECK:          ret i32
+entry:
+  store i32 0, ptr %p, align 4
+  store i32 1, ptr %p, align 4
+  %val = load i32, ptr %p, align 4
+  %sum = add i32 3, %val
+  ret i32 %sum
+}
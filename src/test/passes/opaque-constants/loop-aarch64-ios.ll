@@ -0,0 +1,36 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_all.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; The opaque constant of the loop is computed once in the preheader.
+define void @opaque_loop(ptr %p, i32 %n) {
+; CHECK-LABEL:  define void @opaque_loop(
+; CHECK:        entry:
+; CHECK:          !obf
+; CHECK:          br label %header
+; CHECK:        body:
+; CHECK-NOT:      load volatile
+; CHECK-NOT:      !obf
+; CHECK:          %inc = add i32 %i, %{{[0-9]+}}
+; CHECK-NEXT:     br label %header
+entry:
+  br label %header
+
+header:
+  %i = phi i32 [ 0, %entry ], [ %inc, %body ]
+  %cmp = icmp slt i32 %i, %n
+  br i1 %cmp, label %body, label %exit
+
+body:
+  store i32 %i, ptr %p, align 4
+  %inc = add i32 %i, 1
+  br label %header
+
+exit:
+  ret void
+}
@@ -0,0 +1,26 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target && apple_abi
+
+// The optimizer must not fold the opaque expressions back into the constants
+// they protect, with stack or register seeds.
+
+// RUN: env OMVLL_CONFIG=%S/config_all.py clang -target arm64-apple-ios -fpass-plugin=%libOMVLL -O2 -S -emit-llvm %s -o - | FileCheck %s
+// RUN: env OMVLL_CONFIG=%S/config_register_seeds.py clang -target arm64-apple-ios -fpass-plugin=%libOMVLL -O2 -S -emit-llvm %s -o - | FileCheck %s
+
+// CHECK-LABEL: define {{.*}} @secrets(
+// CHECK-NOT:     1589718640
+// CHECK-NOT:     453030197
+// CHECK-NOT:     202374880
+// CHECK-NOT:     732819469
+// CHECK:         ret void
+
+void secrets(unsigned *Out) {
+  Out[0] = 0x5EC12E70;
+  Out[1] = 0x1B00B135;
+  Out[2] = 0x0C0FFEE0;
+  Out[3] = 0x2BADF00D;
+}
@@ -0,0 +1,25 @@
+//
+// This file is distributed under the Apache License v2.0. See LICENSE for
+// details.
+//
+
+// REQUIRES: aarch64-registered-target && apple_abi
+
+// With per-function seeds, the protection of a function does not depend on
+// the functions transformed before it.
+
+// RUN: env OMVLL_CONFIG=%S/config_per_function_seeds.py clang -target arm64-apple-ios -fpass-plugin=%libOMVLL -O0 -S -emit-llvm %s -o %t.all.ll
+// RUN: env OMVLL_CONFIG=%S/config_per_function_seeds.py clang -target arm64-apple-ios -fpass-plugin=%libOMVLL -O0 -S -emit-llvm -DONLY_SECOND %s -o %t.second.ll
+// RUN: sed -n '/^define.*@second(/,/^}/p' %t.all.ll > %t.all.second.ll
+// RUN: sed -n '/^define.*@second(/,/^}/p' %t.second.ll > %t.second.second.ll
+// RUN: diff %t.all.second.ll %t.second.second.ll
+// RUN: FileCheck %s < %t.second.second.ll
+
+// CHECK-LABEL: define {{.*}} @second(
+// CHECK:         load volatile
+
+#ifndef ONLY_SECOND
+int first(int x) { return x * 3 + 7; }
+#endif
+
+int second(int x) { return x * 5 + 11; }
@@ -0,0 +1,26 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_register_seeds.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; The opaque expressions derive from inline-asm seeds, with no stack traffic.
+define i32 @opaque_constants(ptr %p) {
+; CHECK-LABEL:  define i32 @opaque_constants(
+; CHECK:          %opaque.s1 = call i64 asm "", "=r,0"(i64 {{-?[0-9]+}})
+; CHECK-NEXT:     %opaque.s2 = call i64 asm "", "=r,0"(i64 {{-?[0-9]+}})
+; CHECK-NOT:      opaque.t1
+; CHECK-NOT:      opaque.t2
+; CHECK-NOT:      load volatile
+; CHECK-NOT:      store volatile
+; CHECK:          ret i32
+entry:
+  store i32 0, ptr %p, align 4
+  store i32 1, ptr %p, align 4
+  %val = load i32, ptr %p, align 4
+  %sum = add i32 3, %val
+  ret i32 %sum
+}
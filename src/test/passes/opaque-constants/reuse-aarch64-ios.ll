@@ -0,0 +1,24 @@
+;
+; This file is distributed under the Apache License v2.0. See LICENSE for details.
+;
+
+; REQUIRES: aarch64-registered-target && apple_abi
+
+; RUN: env OMVLL_CONFIG=%S/config_reuse.py clang++ -fpass-plugin=%libOMVLL \
+; RUN:         -target arm64-apple-ios17.5.0 -O0 -S -emit-llvm %s -o - | FileCheck %s
+
+; With a reuse factor of 2, two uses of the constant share an opaque
+; expression and the third one gets a fresh expression.
+define void @opaque_constants(ptr %p, ptr %q, ptr %r) {
+; CHECK-LABEL:  define void @opaque_constants(
+; CHECK:          store i32 [[ONE_A:%[0-9]+]], ptr %p, align 4
+; CHECK-NEXT:     store i32 [[ONE_A]], ptr %q, align 4
+; CHECK:          !obf
+; CHECK:          store i32 %{{[0-9]+}}, ptr %r, align 4
+; CHECK-NEXT:     ret void
+entry:
+  store i32 1, ptr %p, align 4
+  store i32 1, ptr %q, align 4
+  store i32 1, ptr %r, align 4
+  ret void
+}